@@ -84,9 +84,11 @@ $${QXLSX_HEADERPATH}xlsxdrawinganchor_p.h \
 $${QXLSX_HEADERPATH}xlsxdrawing_p.h \
 $${QXLSX_HEADERPATH}xlsxformat.h \
 $${QXLSX_HEADERPATH}xlsxformat_p.h \
+$${QXLSX_HEADERPATH}xlsxformulaengine_p.h \
 $${QXLSX_HEADERPATH}xlsxglobal.h \
 $${QXLSX_HEADERPATH}xlsxmediafile_p.h \
 $${QXLSX_HEADERPATH}xlsxnumformatparser_p.h \
+$${QXLSX_HEADERPATH}xlsxrangeindex_p.h \
 $${QXLSX_HEADERPATH}xlsxrelationships_p.h \
 $${QXLSX_HEADERPATH}xlsxrichstring.h \
 $${QXLSX_HEADERPATH}xlsxrichstring_p.h \
@@ -124,8 +126,10 @@ $${QXLSX_SOURCEPATH}xlsxdocument.cpp \
 $${QXLSX_SOURCEPATH}xlsxdrawing.cpp \
 $${QXLSX_SOURCEPATH}xlsxdrawinganchor.cpp \
 $${QXLSX_SOURCEPATH}xlsxformat.cpp \
+$${QXLSX_SOURCEPATH}xlsxformulaengine.cpp \
 $${QXLSX_SOURCEPATH}xlsxmediafile.cpp \
 $${QXLSX_SOURCEPATH}xlsxnumformatparser.cpp \
+$${QXLSX_SOURCEPATH}xlsxrangeindex.cpp \
 $${QXLSX_SOURCEPATH}xlsxrelationships.cpp \
 $${QXLSX_SOURCEPATH}xlsxrichstring.cpp \
 $${QXLSX_SOURCEPATH}xlsxsharedstrings.cpp \
@@ -0,0 +1,57 @@
+// benchmark.cpp
+
+#include "benchmark.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+Benchmark::Benchmark(const QString &title)
+    : title(title)
+{
+}
+
+qint64 Benchmark::time(const QString &label, const std::function<void()> &step, int rounds)
+{
+    QElapsedTimer timer;
+    timer.start();
+    step();
+    const qint64 ns = timer.nsecsElapsed();
+
+    if (rounds > 0)
+        entries.append(QStringLiteral("%1: %2 ns/round").arg(label).arg(double(ns) / rounds, 0, 'f', 1));
+    else
+        entries.append(QStringLiteral("%1: %2 ms").arg(label).arg(ns / 1e6, 0, 'f', 3));
+    return ns;
+}
+
+void Benchmark::note(const QString &label, const QVariant &value)
+{
+    entries.append(QStringLiteral("%1 = %2").arg(label, value.toString()));
+}
+
+void Benchmark::report() const
+{
+    qDebug().noquote() << QStringLiteral("===== %1 =====").arg(title);
+    qDebug().noquote() << entries.join(QStringLiteral(", "));
+}
+
+int runBenchmarks(const QList<BenchmarkCase> &cases, const QStringList &arguments)
+{
+    QStringList available;
+    for (const BenchmarkCase &benchmarkCase : cases)
+        available.append(QString::fromLatin1(benchmarkCase.name));
+
+    for (const QString &name : arguments) {
+        if (!available.contains(name)) {
+            qWarning().noquote() << QStringLiteral("Unknown benchmark %1, available: %2")
+                                        .arg(name, available.join(QStringLiteral(" ")));
+            return 1;
+        }
+    }
+
+    for (const BenchmarkCase &benchmarkCase : cases) {
+        if (arguments.isEmpty() || arguments.contains(QString::fromLatin1(benchmarkCase.name)))
+            benchmarkCase.run();
+    }
+    return 0;
+}
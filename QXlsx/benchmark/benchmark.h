@@ -0,0 +1,48 @@
+// benchmark.h
+
+#ifndef QXLSX_BENCHMARK_H
+#define QXLSX_BENCHMARK_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+
+#include <functional>
+
+/*
+ * Shared harness of the QXlsx benchmarks.
+ *
+ * A benchmark times its steps with time() and records the values it
+ * checks with note(); report() prints them on one line under the title.
+ */
+class Benchmark
+{
+public:
+    explicit Benchmark(const QString &title);
+
+    // Runs \a step once and records its wall time. With \a rounds, the
+    // step is expected to loop that many times and the time is reported
+    // per round instead.
+    qint64 time(const QString &label, const std::function<void()> &step, int rounds = 0);
+    void note(const QString &label, const QVariant &value);
+    void report() const;
+
+private:
+    QString title;
+    QStringList entries;
+};
+
+struct BenchmarkCase
+{
+    const char *name;
+    void (*run)();
+};
+
+/*
+ * Runs the cases named in \a arguments, or all of them when there are
+ * none. Returns the process exit code.
+ */
+int runBenchmarks(const QList<BenchmarkCase> &cases, const QStringList &arguments);
+
+#endif // QXLSX_BENCHMARK_H
@@ -0,0 +1,19 @@
+# benchmark.pro
+
+TARGET = qxlsxbenchmark
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+QT += core gui
+
+QXLSX_PARENTPATH=$$PWD/../
+QXLSX_HEADERPATH=$$PWD/../header/
+QXLSX_SOURCEPATH=$$PWD/../source/
+include($$PWD/../QXlsx.pri)
+
+HEADERS += \
+    benchmark.h
+
+SOURCES += \
+    benchmark.cpp \
+    main.cpp
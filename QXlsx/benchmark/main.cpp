@@ -0,0 +1,239 @@
+// main.cpp
+//
+// QXlsx benchmarks. Run without arguments for all of them, or name the
+// ones to run, e.g. "qxlsxbenchmark formulas".
+
+#include "benchmark.h"
+#include "xlsxcellreference.h"
+#include "xlsxdocument.h"
+#include "xlsxworkbook.h"
+
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QDate>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+// A 100k formula sheet: full calculation, then the incremental
+// recalculation after one precedent changes
+static void benchmarkFormulas()
+{
+    const int rows = 100000;
+    Benchmark benchmark(QStringLiteral("Formula recalculation (%1 formulas)").arg(rows));
+
+    QXlsx::Document xlsx;
+    benchmark.time(QStringLiteral("write"), [&]() {
+        for (int row = 1; row <= rows; ++row) {
+            xlsx.write(row, 1, row);
+            // Column B is a running total, C1 sums the whole column
+            xlsx.write(row, 2,
+                       row == 1 ? QStringLiteral("=A1")
+                                : QStringLiteral("=B%1+A%2").arg(row - 1).arg(row));
+        }
+        xlsx.write(1, 3, QStringLiteral("=SUM(B1:B%1)").arg(rows));
+    });
+
+    // Fetching a cell triggers the recalculation
+    benchmark.time(QStringLiteral("full calculation"), [&]() { xlsx.cellAt(1, 3); });
+    benchmark.time(QStringLiteral("incremental recalculation"), [&]() {
+        // Only touches the last B formula and C1
+        xlsx.write(rows, 1, 0);
+        xlsx.cellAt(1, 3);
+    });
+    benchmark.note(QStringLiteral("C1"), xlsx.cellAt(1, 3)->value().toLongLong());
+    benchmark.report();
+}
+
+// A1 references parsed to row/column and formatted back
+static void benchmarkCellRefs()
+{
+    const int rounds = 1000000;
+    Benchmark benchmark(QStringLiteral("Cell reference codec (%1 rounds)").arg(rounds));
+
+    const QStringList refs = {QStringLiteral("A1"),
+                              QStringLiteral("Z99"),
+                              QStringLiteral("AB1234"),
+                              QStringLiteral("XFD1048576")};
+    qint64 checksum = 0;
+    benchmark.time(
+        QStringLiteral("parse"),
+        [&]() {
+            for (int i = 0; i < rounds; ++i) {
+                QXlsx::CellReference ref(refs.at(i % refs.size()));
+                checksum += ref.row() + ref.column();
+            }
+        },
+        rounds);
+    benchmark.time(
+        QStringLiteral("format"),
+        [&]() {
+            for (int i = 0; i < rounds; ++i)
+                checksum += QXlsx::CellReference(i % 1048576 + 1, i % 16384 + 1).toString().size();
+        },
+        rounds);
+    benchmark.note(QStringLiteral("checksum"), checksum);
+    benchmark.report();
+}
+
+// A 100k cell template sheet copied, then one cell of the copy written
+static void benchmarkSheetCopy()
+{
+    const int rows = 10000;
+    const int cols = 10;
+    Benchmark benchmark(QStringLiteral("Sheet copy (%1 cells)").arg(rows * cols));
+
+    QXlsx::Document xlsx;
+    for (int row = 1; row <= rows; ++row) {
+        for (int col = 1; col <= cols; ++col)
+            xlsx.write(row, col, row * col);
+    }
+
+    const QString source = xlsx.currentSheet()->sheetName();
+    benchmark.time(QStringLiteral("copy"), [&]() { xlsx.copySheet(source, QStringLiteral("Copy")); });
+    benchmark.time(QStringLiteral("first write to the copy"), [&]() {
+        xlsx.selectSheet(QStringLiteral("Copy"));
+        xlsx.write(1, 1, QStringLiteral("Department"));
+    });
+
+    // Writing the copy must leave the source alone
+    xlsx.selectSheet(source);
+    benchmark.note(QStringLiteral("source A1"), xlsx.read(1, 1));
+    benchmark.report();
+}
+
+// Opening a large workbook of mixed numbers, shared strings and styled dates
+static void benchmarkLoad()
+{
+    const int rows = 200000;
+    const int cols = 10;
+    Benchmark benchmark(QStringLiteral("Workbook load (%1 cells)").arg(rows * cols));
+
+    const QString path = QDir::temp().filePath(QStringLiteral("qxlsx_benchmark_load.xlsx"));
+    {
+        QXlsx::Document xlsx;
+        QXlsx::Format dateFormat;
+        dateFormat.setNumberFormat(QStringLiteral("yyyy-mm-dd"));
+        for (int row = 1; row <= rows; ++row) {
+            for (int col = 1; col <= cols; ++col) {
+                if (col % 3 == 0)
+                    xlsx.write(row, col, QStringLiteral("Task %1").arg(row % 1000));
+                else if (col % 5 == 0)
+                    xlsx.write(row, col, QDate(2024, 1, 1).addDays(row % 365), dateFormat);
+                else
+                    xlsx.write(row, col, row * 0.5 + col);
+            }
+        }
+        xlsx.saveAs(path);
+    }
+    benchmark.note(QStringLiteral("file MB"), QString::number(QFileInfo(path).size() / 1048576.0, 'f', 1));
+
+    QVariant lastRow;
+    benchmark.time(QStringLiteral("load"), [&]() {
+        QXlsx::Document loaded(path);
+        lastRow = loaded.read(rows, 1);
+    });
+    // On demand, opening only parses the workbook structure and the sheet
+    // is parsed on first access
+    benchmark.time(QStringLiteral("load on demand"),
+                   [&]() { QXlsx::Document lazy(path, QXlsx::Document::LoadSheetsOnDemand); });
+    benchmark.time(QStringLiteral("load on demand and read"), [&]() {
+        QXlsx::Document lazy(path, QXlsx::Document::LoadSheetsOnDemand);
+        lazy.read(rows, 1);
+    });
+    benchmark.note(QStringLiteral("last row A"), lastRow);
+    benchmark.report();
+    QFile::remove(path);
+}
+
+// One PNG inserted many times on two sheets, as a QImage and as encoded
+// bytes; the workbook should keep a single media file
+static void benchmarkImages()
+{
+    const int count = 1000;
+    Benchmark benchmark(QStringLiteral("Image insertion (%1 per sheet)").arg(count));
+
+    QImage image(256, 256, QImage::Format_ARGB32);
+    image.fill(Qt::darkCyan);
+    QByteArray png;
+    QBuffer buffer(&png);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "PNG");
+
+    QXlsx::Document xlsx;
+    xlsx.addSheet(QStringLiteral("Encoded"));
+    benchmark.time(QStringLiteral("insert QImage"), [&]() {
+        xlsx.selectSheet(xlsx.sheetNames().first());
+        for (int i = 0; i < count; ++i)
+            xlsx.insertImage(i * 20 + 1, 1, image);
+    });
+    benchmark.time(QStringLiteral("insert encoded bytes"), [&]() {
+        xlsx.selectSheet(QStringLiteral("Encoded"));
+        for (int i = 0; i < count; ++i)
+            xlsx.insertImage(i * 20 + 1, 1, png);
+    });
+    benchmark.note(QStringLiteral("media files"), xlsx.workbook()->mediaFiles().size());
+    benchmark.report();
+}
+
+// Ten thousand 2x2 merged blocks, as in a report: merging with the
+// overlap check, then looking up the merge of every cell
+static void benchmarkMerges()
+{
+    const int blocks = 10000;
+    const int rows = (blocks / 50) * 2;
+    Benchmark benchmark(QStringLiteral("Merged cells (%1 merges)").arg(blocks));
+
+    QXlsx::Document xlsx;
+    QXlsx::Worksheet *sheet = xlsx.currentWorksheet();
+    benchmark.time(QStringLiteral("merge"), [&]() {
+        for (int i = 0; i < blocks; ++i) {
+            const int row = (i / 50) * 2 + 1;
+            const int col = (i % 50) * 2 + 1;
+            sheet->mergeCells(QXlsx::CellRange(row, col, row + 1, col + 1));
+        }
+    });
+
+    // An overlapping merge must be rejected
+    benchmark.note(QStringLiteral("overlap rejected"),
+                   !sheet->mergeCells(QXlsx::CellRange(2, 2, 3, 3)));
+
+    int merged = 0;
+    benchmark.time(QStringLiteral("look up %1 cells").arg(rows * 100), [&]() {
+        for (int row = 1; row <= rows; ++row) {
+            for (int col = 1; col <= 100; ++col) {
+                if (sheet->mergedRangeAt(row, col).isValid())
+                    ++merged;
+            }
+        }
+    });
+    benchmark.note(QStringLiteral("hits"), merged);
+
+    // Only the top-left cell of each block takes a value
+    int refused = 0;
+    benchmark.time(QStringLiteral("write %1 cells").arg(rows * 100), [&]() {
+        for (int row = 1; row <= rows; ++row) {
+            for (int col = 1; col <= 100; ++col) {
+                if (!sheet->write(row, col, row * col))
+                    ++refused;
+            }
+        }
+    });
+    benchmark.note(QStringLiteral("writes refused"), refused);
+    benchmark.report();
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    const QList<BenchmarkCase> cases = {
+        {"cellrefs", benchmarkCellRefs},
+        {"formulas", benchmarkFormulas},
+        {"images", benchmarkImages},
+        {"load", benchmarkLoad},
+        {"merges", benchmarkMerges},
+        {"sheetcopy", benchmarkSheetCopy},
+    };
+    return runBenchmarks(cases, app.arguments().mid(1));
+}
@@ -28,6 +28,10 @@ public:
 
     Relationships *relationships() const;
 
+    void setSourceXml(const QByteArray &xml);
+    void markModified();
+    bool isModified() const;
+
     void setFilePath(const QString path);
     QString filePath() const;
 
@@ -22,6 +22,7 @@ public:
 
     Relationships *relationships;
     AbstractOOXmlFile::CreateFlag flag;
+    QByteArray sourceXml; // loaded xml, saved back as is until the part is modified
     AbstractOOXmlFile *q_ptr;
 };
 
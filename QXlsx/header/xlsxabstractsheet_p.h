@@ -10,6 +10,8 @@
 
 #include <memory>
 
+#include <QByteArray>
+
 #include <QString>
 
 QT_BEGIN_NAMESPACE_XLSX
@@ -21,6 +23,11 @@ public:
     AbstractSheetPrivate(AbstractSheet *p, AbstractSheet::CreateFlag flag);
     ~AbstractSheetPrivate();
 
+    bool loadFromXml(const QByteArray &xml);
+    void loadDeferred();
+    // False when the loaded xml is already out of date, see WorksheetPrivate
+    virtual bool canKeepSourceXml() const { return true; }
+
     Workbook *workbook;
     std::shared_ptr<Drawing> drawing;
 
@@ -28,6 +35,16 @@ public:
     int id;
     AbstractSheet::SheetState sheetState;
     AbstractSheet::SheetType type;
+
+    // Sheets opened with Document::LoadSheetsOnDemand keep their raw xml
+    // here until first accessed through the workbook. Their shared string
+    // references are not counted until then: counting them would take the
+    // same pass over the xml that deferring avoids.
+    bool deferred{false};
+    QByteArray deferredXml;
+    // Keep the loaded xml to save the sheet as is while it is not modified,
+    // see Document::KeepSourceXml
+    bool keepSourceXml{false};
 };
 
 QT_END_NAMESPACE_XLSX
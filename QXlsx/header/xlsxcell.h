@@ -30,6 +30,7 @@ class QXLSX_EXPORT Cell
 private:
     friend class Worksheet;
     friend class WorksheetPrivate;
+    friend class FormulaEngine;
 
 public:
     enum CellType // See ECMA 376, 18.18.11. ST_CellType (Cell Type) for more information.
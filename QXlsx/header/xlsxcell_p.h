@@ -14,6 +14,8 @@
 
 QT_BEGIN_NAMESPACE_XLSX
 
+class Workbook;
+
 class CellPrivate
 {
     Q_DECLARE_PUBLIC(Cell)
@@ -22,7 +24,10 @@ public:
     CellPrivate(const CellPrivate *const cp);
 
 public:
-    Worksheet *parent;
+    // Workbook of the sheet the cell was created in. Cells of copied sheets
+    // are shared between sheets of the same workbook, so no single sheet
+    // owns them.
+    Workbook *workbook;
     Cell *q_ptr;
 
 public:
@@ -48,6 +48,7 @@ public:
 private:
     friend class Worksheet;
     friend class WorksheetPrivate;
+    friend class FormulaEngine;
     QExplicitlySharedDataPointer<CellFormulaPrivate> d;
 };
 
@@ -30,9 +30,18 @@ class QXLSX_EXPORT Document : public QObject
     Q_DECLARE_PRIVATE(Document) // D-Pointer. Qt classes have a Q_DECLARE_PRIVATE
                                 // macro in the public class. The macro reads: qglobal.h
 public:
+    enum LoadOption {
+        LoadAllSheets      = 0x0, // parse every sheet when the document is opened
+        LoadSheetsOnDemand = 0x1, // parse a worksheet on first access, save untouched ones as is
+        KeepSourceXml      = 0x2  // keep the loaded xml to save unmodified parts as is
+    };
+    Q_DECLARE_FLAGS(LoadOptions, LoadOption)
+
     explicit Document(QObject *parent = nullptr);
     Document(const QString &xlsxName, QObject *parent = nullptr);
+    Document(const QString &xlsxName, LoadOptions options, QObject *parent = nullptr);
     Document(QIODevice *device, QObject *parent = nullptr);
+    Document(QIODevice *device, LoadOptions options, QObject *parent = nullptr);
     ~Document();
 
     bool write(const CellReference &cell, const QVariant &value, const Format &format = Format());
@@ -42,6 +51,7 @@ public:
     QVariant read(int row, int col) const;
 
     int insertImage(int row, int col, const QImage &image);
+    int insertImage(int row, int col, const QByteArray &bytes);
     bool getImage(int imageIndex, QImage &img);
     bool getImage(int row, int col, QImage &img);
     uint getImageCount();
@@ -153,6 +163,8 @@ private:
     DocumentPrivate *const d_ptr;
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(Document::LoadOptions)
+
 QT_END_NAMESPACE_XLSX
 
 #endif // QXLSX_XLSXDOCUMENT_H
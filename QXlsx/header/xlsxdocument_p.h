@@ -21,7 +21,7 @@ public:
     DocumentPrivate(Document *p);
     void init();
 
-    bool loadPackage(QIODevice *device);
+    bool loadPackage(QIODevice *device, Document::LoadOptions options = Document::LoadAllSheets);
     bool savePackage(QIODevice *device) const;
 
     bool saveCsv(const QString mainCSVFileName) const;
@@ -7,6 +7,7 @@
 
 #include <memory>
 
+#include <QByteArray>
 #include <QPoint>
 #include <QSize>
 #include <QString>
@@ -46,6 +47,7 @@ public:
     virtual ~DrawingAnchor();
 
     void setObjectPicture(const QImage &img);
+    void setObjectPicture(const QByteArray &bytes, const QString &suffix, const QString &mimeType);
     bool getObjectPicture(QImage &img);
 
     void setObjectGraphicFrame(std::shared_ptr<QXlsx::Chart> chart);
@@ -0,0 +1,170 @@
+// xlsxformulaengine_p.h
+
+#ifndef XLSXFORMULAENGINE_P_H
+#define XLSXFORMULAENGINE_P_H
+
+#include "xlsxglobal.h"
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+class Cell;
+class WorksheetPrivate;
+
+/*
+ * Evaluates the formulas of one worksheet.
+ *
+ * Supported are numbers, strings, booleans, error literals, same-sheet
+ * A1 references and ranges, the arithmetic / concatenation / comparison
+ * operators and the functions SUM, COUNT, AVERAGE, IF, MIN and MAX.
+ * Formulas using anything else are left alone and keep the cached value
+ * they were loaded or written with.
+ *
+ * Every supported formula is compiled once into a postfix program and
+ * linked into a dependency graph (single cell precedents in a hash, range
+ * precedents bucketed by column, or by band of rows when they are wide).
+ * A write marks the transitive dependents of the written cell dirty;
+ * recalculate() evaluates only the dirty formulas, precedents first, and
+ * stores the results as the cached cell values that are written out on
+ * save.
+ */
+class FormulaEngine
+{
+public:
+    explicit FormulaEngine(WorksheetPrivate *sheet);
+    ~FormulaEngine();
+
+    void cellChanged(int row, int column);
+    void recalculate();
+    bool isDirty() const { return !dirty.isEmpty(); }
+
+    // Compiled formulas and the values they evaluate to
+    struct Area
+    {
+        int firstRow;
+        int firstColumn;
+        int lastRow;
+        int lastColumn;
+
+        bool contains(int row, int column) const
+        {
+            return row >= firstRow && row <= lastRow && column >= firstColumn &&
+                   column <= lastColumn;
+        }
+    };
+
+    struct Value
+    {
+        enum Type : quint8 { Empty, Number, String, Boolean, Error, Reference, Missing };
+
+        Type type{Empty};
+        double number{0};
+        QString text; // String and Error
+        Area area{0, 0, 0, 0};
+    };
+
+    enum OpCode : quint8 {
+        PushNumber,
+        PushString,
+        PushBoolean,
+        PushError,
+        PushReference,
+        PushMissing,
+        Negate,
+        Percent,
+        Add,
+        Subtract,
+        Multiply,
+        Divide,
+        Power,
+        Concat,
+        Equal,
+        NotEqual,
+        Less,
+        Greater,
+        LessEqual,
+        GreaterEqual,
+        Call
+    };
+
+    enum Function : quint8 { Sum, Count, Average, If, Min, Max };
+
+    struct Op
+    {
+        OpCode code;
+        quint8 function; // Call only
+        int argc;        // Call only, or index into Program::strings
+        double number;
+        Area area;
+    };
+
+    struct Program
+    {
+        QVector<Op> ops;
+        QStringList strings;
+    };
+
+private:
+    struct Node
+    {
+        Program program;
+        QVector<quint64> cells; // single cell precedents
+        QVector<Area> ranges;   // range precedents
+        bool dirty{false};
+        bool circular{false};
+        quint8 state{0};        // depth first search state during recalculate()
+    };
+
+    struct RangeLink
+    {
+        Area area;
+        quint64 formula;
+    };
+
+    class Parser;
+
+    static quint64 keyOf(int row, int column)
+    {
+        return (quint64(quint32(row)) << 32) | quint32(column);
+    }
+    static int rowOf(quint64 key) { return int(key >> 32); }
+    static int columnOf(quint64 key) { return int(key & 0xffffffff); }
+
+    void ensureIndexed();
+    bool compile(int row, int column, const Cell *cell, Node &node) const;
+    void link(quint64 key, const Node &node);
+    void unlink(quint64 key, const Node &node);
+    void markDependentsDirty(quint64 key);
+    void dirtyPrecedents(const Node &node, QVector<quint64> &out) const;
+
+    template <typename Visitor>
+    void forEachCell(const Area &area, Visitor visit) const;
+
+    Value evaluate(const Node &node);
+    Value valueOf(const Cell *cell) const;
+    Value cellValue(int row, int column) const;
+    Value scalar(const Value &value) const;
+    Value callFunction(quint8 function, const Value *args, int argc) const;
+    void store(int row, int column, const Value &value);
+
+    WorksheetPrivate *sheet;
+    bool indexed{false};
+
+    QHash<quint64, Node> nodes;                      // formula cells
+    QHash<quint64, QVector<quint64>> cellDependents; // precedent ==> formula cells
+    QHash<int, QVector<RangeLink>> columnRanges;     // narrow ranges, by column
+    QHash<int, QVector<RangeLink>> rowBandRanges;    // wide, short ranges, by band of rows
+    QVector<RangeLink> wideRanges;                   // ranges both tall and wide
+    QSet<quint64> dirty;
+
+    QVector<Value> stack; // evaluation stack, reused between formulas
+};
+
+QT_END_NAMESPACE_XLSX
+
+#endif // XLSXFORMULAENGINE_P_H
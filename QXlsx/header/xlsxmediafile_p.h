@@ -6,6 +6,7 @@
 #include "xlsxglobal.h"
 
 #include <QByteArray>
+#include <QImage>
 #include <QString>
 
 QT_BEGIN_NAMESPACE_XLSX
@@ -21,11 +22,12 @@ public:
     QString suffix() const;
     QString mimeType() const;
     QByteArray contents() const;
+    QImage image() const;
 
     bool isIndexValid() const;
     int index() const;
     void setIndex(int idx);
-    QByteArray hashKey() const;
+    quint64 hashKey() const;
 
     void setFileName(const QString &name);
     QString fileName() const;
@@ -38,7 +40,10 @@ protected:
 
     int m_index;
     bool m_indexValid;
-    QByteArray m_hashKey;
+    quint64 m_hashKey;
+
+    // Decoded on the first image() call, dropped by set()
+    mutable QImage m_image;
 };
 
 QT_END_NAMESPACE_XLSX
@@ -0,0 +1,73 @@
+// xlsxrangeindex_p.h
+
+#ifndef XLSXRANGEINDEX_P_H
+#define XLSXRANGEINDEX_P_H
+
+#include "xlsxcellrange.h"
+#include "xlsxglobal.h"
+
+#include <QHash>
+#include <QList>
+#include <QVector>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+/*
+ * Finds the items whose cell ranges contain a cell or intersect a range.
+ *
+ * Items are numbered in the order they are appended, so an item is the
+ * position of a merge, data validation or conditional formatting in the
+ * worksheet's list of them; an item may cover several ranges.
+ *
+ * Ranges are bucketed by bands of rows. Ranges too tall for that are
+ * bucketed by bands of columns instead, and the few that are both tall
+ * and wide are kept in one list. A lookup only tests the ranges of the
+ * buckets it falls in, which stays small however many ranges there are.
+ */
+class RangeIndex
+{
+public:
+    // Number of items appended
+    int count() const { return itemCount; }
+    void clear();
+    void append(const QList<CellRange> &ranges);
+
+    // Items in ascending order, each at most once
+    QVector<int> itemsAt(int row, int column) const;
+    QVector<int> itemsIntersecting(const CellRange &range) const;
+
+private:
+    struct Entry
+    {
+        int firstRow;
+        int firstColumn;
+        int lastRow;
+        int lastColumn;
+        int item;
+
+        bool intersects(int top, int left, int bottom, int right) const
+        {
+            return firstRow <= bottom && lastRow >= top && firstColumn <= right &&
+                   lastColumn >= left;
+        }
+    };
+
+    void collect(const QVector<int> &bucket,
+                 const CellRange &range,
+                 QVector<int> &items) const;
+    void collectBands(const QHash<int, QVector<int>> &bands,
+                      int firstBand,
+                      int lastBand,
+                      const CellRange &range,
+                      QVector<int> &items) const;
+
+    QVector<Entry> entries;
+    QHash<int, QVector<int>> rowBands;    // short ranges, by band of rows
+    QHash<int, QVector<int>> columnBands; // tall, narrow ranges, by band of columns
+    QVector<int> wideRanges;              // tall and wide ranges
+    int itemCount{0};
+};
+
+QT_END_NAMESPACE_XLSX
+
+#endif // XLSXRANGEINDEX_P_H
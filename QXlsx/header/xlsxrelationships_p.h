@@ -77,6 +77,7 @@ public:
     void clear();
     int count() const;
     bool isEmpty() const;
+    bool hasOnlyExternalTargets() const;
 
 private:
     QList<XlsxRelationship> relationships(const QString &type) const;
@@ -72,7 +72,8 @@ public:
     int addSharedString(const RichString &string);
     void removeSharedString(const QString &string);
     void removeSharedString(const RichString &string);
-    void incRefByStringIndex(int idx);
+    void incRefByStringIndex(int idx, int count = 1);
+    void addReferences(int count);
 
     int getSharedStringIndex(const QString &string) const;
     int getSharedStringIndex(const RichString &string) const;
@@ -75,6 +75,7 @@ public:
     ~Styles();
     void addXfFormat(const Format &format, bool force = false);
     Format xfFormat(int idx) const;
+    int xfFormatCount() const;
     void addDxfFormat(const Format &format, bool force = false);
     Format dxfFormat(int idx) const;
 
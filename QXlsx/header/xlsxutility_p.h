@@ -12,8 +12,10 @@
 #include <QPoint>
 #include <QString>
 #include <QStringList>
+#include <QStringView>
 #include <QTime>
 #include <QVariant>
+#include <QVector>
 
 QT_BEGIN_NAMESPACE_XLSX
 
@@ -35,9 +37,59 @@ QString unescapeSheetName(const QString &sheetName);
 
 bool isSpaceReserveNeeded(const QString &string);
 
+/*
+ * Allocation-free A1 reference codec used by the writer, the loaders and the
+ * formula code. flags: 0x01 ==> $A1, 0x02 ==> A$1.
+ *
+ * Parsing accepts "$?[A-Z]{1,3}$?[0-9]{1,9}" covering the whole input and
+ * within A1:XFD1048576. parseColumnLetters() measures a run of letters of
+ * any length but only converts the first three. Writing fills a caller supplied
+ * buffer of at least CellRefBufferSize characters and returns the length,
+ * or 0 for an invalid reference.
+ */
+enum { CellRefBufferSize = 24 };
+
+int parseColumnLetters(QStringView text, int *length);
+bool parseCellRef(QStringView text, int *row, int *column, int *flags = nullptr);
+bool parseCellRef(const char *text, int size, int *row, int *column, int *flags = nullptr);
+int writeColumnLetters(QChar *buffer, int column);
+int writeCellRef(QChar *buffer, int row, int column, int flags = 0);
+int writeCellRef(char *buffer, int row, int column, int flags = 0);
+
 QString convertSharedFormula(const QString &rootFormula,
                              const CellReference &rootCell,
                              const CellReference &cell);
 
+/*
+ * The root formula of a shared formula group, tokenised once into literal
+ * runs and cell references so that the formula of every dependent cell can
+ * be produced by offsetting the relative references.
+ */
+class SharedFormulaTemplate
+{
+public:
+    SharedFormulaTemplate() = default;
+    SharedFormulaTemplate(const QString &rootFormula, const CellReference &rootCell);
+
+    QString instantiate(const CellReference &cell) const;
+
+private:
+    struct Token
+    {
+        int begin;  // offset of a literal run in formula, or -1 for a reference
+        int length; // length of a literal run
+        int row;    // reference row (references only)
+        int column; // reference column (references only)
+        int flags;  // 0x01 ==> $A1, 0x02 ==> A$1
+    };
+
+    void appendLiteral(int begin, int length);
+
+    QString formula;
+    QVector<Token> tokens;
+    int rootRow{0};
+    int rootColumn{0};
+};
+
 QT_END_NAMESPACE_XLSX
 #endif // XLSXUTILITY_H
@@ -69,8 +69,9 @@ public:
     bool writeDatesAsText() const;
 
     // internal used member
-    void addMediaFile(std::shared_ptr<MediaFile> media, bool force = false);
+    std::shared_ptr<MediaFile> addMediaFile(std::shared_ptr<MediaFile> media, bool force = false);
     QList<std::shared_ptr<MediaFile>> mediaFiles() const;
+    std::shared_ptr<MediaFile> mediaFile(const QString &fileName) const;
     void addChartFile(std::shared_ptr<Chart> chartFile);
     QList<std::shared_ptr<Chart>> chartFiles() const;
 
@@ -9,6 +9,8 @@
 #include "xlsxtheme_p.h"
 #include "xlsxworkbook.h"
 
+#include <QHash>
+#include <QMultiHash>
 #include <QStringList>
 
 QT_BEGIN_NAMESPACE_XLSX
@@ -48,6 +50,11 @@ public:
     std::shared_ptr<Styles> styles;
     std::shared_ptr<Theme> theme;
     QList<std::shared_ptr<MediaFile>> mediaFiles;
+    // Index of mediaFiles by content hash, rebuilt lazily once the contents
+    // of loaded files are known, and by package path for loaded files.
+    QMultiHash<quint64, int> mediaFileHashes;
+    bool mediaFileHashesValid{true};
+    QHash<QString, int> mediaFileNames;
     QList<std::shared_ptr<Chart>> chartFiles;
     QList<XlsxDefineNameData> definedNamesList;
 
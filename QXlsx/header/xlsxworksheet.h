@@ -37,9 +37,17 @@ class Chart;
 class WorksheetPrivate;
 class QXLSX_EXPORT Worksheet : public AbstractSheet
 {
-    Q_DECLARE_PRIVATE(Worksheet)
+    // Q_DECLARE_PRIVATE(Worksheet), except that non-const access marks the
+    // sheet modified, so that it is serialised again on save.
+    WorksheetPrivate *d_func();
+    inline const WorksheetPrivate *d_func() const
+    {
+        return reinterpret_cast<const WorksheetPrivate *>(d_ptr);
+    }
+    friend class WorksheetPrivate;
 
 private:
+    friend class Document;
     friend class DocumentPrivate;
     friend class Workbook;
     friend class ::WorksheetTest;
@@ -125,11 +133,14 @@ public:
 
     bool addDataValidation(const DataValidation &validation);
     bool addConditionalFormatting(const ConditionalFormatting &cf);
+    QList<DataValidation> dataValidationsAt(int row, int column) const;
+    QList<ConditionalFormatting> conditionalFormattingsAt(int row, int column) const;
 
     std::shared_ptr<Cell> cellAt(const CellReference &row_column) const;
     std::shared_ptr<Cell> cellAt(int row, int column) const;
 
     int insertImage(int row, int column, const QImage &image);
+    int insertImage(int row, int column, const QByteArray &bytes);
     bool getImage(int imageIndex, QImage &img);
     bool getImage(int row, int column, QImage &img);
     uint getImageCount();
@@ -139,6 +150,7 @@ public:
     bool mergeCells(const CellRange &range, const Format &format = Format());
     bool unmergeCells(const CellRange &range);
     QList<CellRange> mergedCells() const;
+    CellRange mergedRangeAt(int row, int column) const;
 
     bool setColumnWidth(const CellRange &range, double width);
     bool setColumnFormat(const CellRange &range, const Format &format);
@@ -8,20 +8,28 @@
 #include "xlsxcellformula.h"
 #include "xlsxconditionalformatting.h"
 #include "xlsxdatavalidation.h"
+#include "xlsxrangeindex_p.h"
+#include "xlsxutility_p.h"
 #include "xlsxworksheet.h"
 
 #include <QHash>
 #include <QImage>
 #include <QObject>
+#include <QPair>
 #include <QRegularExpression>
 #include <QString>
 #include <QVector>
 
+#include <algorithm>
+#include <climits>
+#include <memory>
+
 class QXmlStreamWriter;
 class QXmlStreamReader;
 
 QT_BEGIN_NAMESPACE_XLSX
 
+class FormulaEngine;
 class SharedStrings;
 
 struct XlsxHyperlinkData {
@@ -135,6 +143,12 @@ struct XlsxColumnInfo {
 class CellTable
 {
 public:
+    // Populated columns of one row
+    struct ColumnSpan {
+        int first;
+        int last;
+    };
+
     static QList<int> sorteIntList(QList<int> &&keys)
     {
         std::sort(keys.begin(), keys.end());
@@ -148,13 +162,82 @@ public:
         return keys;
     }
 
+    // Columns of the row in ascending order, limited to [firstCol, lastCol]
+    QList<int> sortedColumns(int row, int firstCol = 1, int lastCol = INT_MAX) const
+    {
+        QList<int> result;
+        auto it     = cells.constFind(row);
+        auto spanIt = rowSpans.constFind(row);
+        if (it == cells.constEnd() || spanIt == rowSpans.constEnd())
+            return result;
+
+        const int first = qMax(firstCol, spanIt->first);
+        const int last  = qMin(lastCol, spanIt->last);
+        if (first > last)
+            return result;
+
+        result.reserve(qMin<qint64>(it->size(), qint64(last) - first + 1));
+        if (qint64(last) - first + 1 <= 2 * qint64(it->size())) {
+            // Dense row: walking the span is cheaper than sorting the keys
+            for (int col = first; col <= last; ++col) {
+                if (it->contains(col))
+                    result.append(col);
+            }
+        } else {
+            for (auto colIt = it->constBegin(); colIt != it->constEnd(); ++colIt) {
+                if (colIt.key() >= first && colIt.key() <= last)
+                    result.append(colIt.key());
+            }
+            std::sort(result.begin(), result.end());
+        }
+        return result;
+    }
+
     void setValue(int row, int column, const std::shared_ptr<Cell> &cell)
     {
-        cells[row].insert(column, cell);
-        firstRow    = qMin(firstRow, row);
-        firstColumn = qMin(firstColumn, column);
-        lastRow     = qMin(lastRow, row);
-        lastColumn  = qMin(lastColumn, column);
+        auto &rowCells = cells[row];
+        auto it        = rowCells.find(column);
+        if (it == rowCells.end()) {
+            rowCells.insert(column, cell);
+            ++cellCount;
+        } else {
+            if ((*it)->cellType() == Cell::SharedStringType)
+                --sharedStringCount;
+            *it = cell;
+        }
+        if (cell->cellType() == Cell::SharedStringType)
+            ++sharedStringCount;
+
+        extendBounds(row, ColumnSpan{column, column});
+    }
+
+    // Inserts the cells of one row in one go, used while loading
+    void setRowValues(int row, const QVector<QPair<int, std::shared_ptr<Cell>>> &values)
+    {
+        if (values.isEmpty())
+            return;
+        if (cells.contains(row)) {
+            for (const auto &value : values)
+                setValue(row, value.first, value.second);
+            return;
+        }
+
+        QHash<int, std::shared_ptr<Cell>> rowCells;
+        rowCells.reserve(values.size());
+        ColumnSpan span{values.first().first, values.first().first};
+        for (const auto &value : values) {
+            std::shared_ptr<Cell> &slot = rowCells[value.first];
+            if (slot && slot->cellType() == Cell::SharedStringType)
+                --sharedStringCount;
+            slot = value.second;
+            if (slot->cellType() == Cell::SharedStringType)
+                ++sharedStringCount;
+            span.first = qMin(span.first, value.first);
+            span.last  = qMax(span.last, value.first);
+        }
+        cellCount += rowCells.size();
+        cells.insert(row, rowCells);
+        extendBounds(row, span);
     }
 
     std::shared_ptr<Cell> cellAt(int row, int column) const
@@ -172,14 +255,51 @@ public:
     }
 
     bool isEmpty() const { return cells.isEmpty(); }
+    int count() const { return cellCount; }
+
+    // Bounding box of all cells, invalid when the table is empty
+    CellRange bounds() const
+    {
+        if (firstRow == -1)
+            return CellRange();
+        return CellRange(firstRow, firstColumn, lastRow, lastColumn);
+    }
 
     // It's faster with a single QHash, but in Qt5 it's capacity limits
-    // how much cells we can hold
+    // how much cells we can hold. Copying the table shares the hashes and
+    // the cells, see WorksheetPrivate::detachCell().
     QHash<int, QHash<int, std::shared_ptr<Cell>>> cells;
+    QHash<int, ColumnSpan> rowSpans; // populated column span of each row
+    int cellCount         = 0;
+    int sharedStringCount = 0;
     int firstRow    = -1;
     int firstColumn = -1;
     int lastRow     = -1;
     int lastColumn  = -1;
+
+private:
+    void extendBounds(int row, const ColumnSpan &columns)
+    {
+        auto spanIt = rowSpans.find(row);
+        if (spanIt == rowSpans.end()) {
+            rowSpans.insert(row, columns);
+        } else {
+            spanIt->first = qMin(spanIt->first, columns.first);
+            spanIt->last  = qMax(spanIt->last, columns.last);
+        }
+
+        if (firstRow == -1) {
+            firstRow    = row;
+            firstColumn = columns.first;
+            lastRow     = row;
+            lastColumn  = columns.last;
+        } else {
+            firstRow    = qMin(firstRow, row);
+            firstColumn = qMin(firstColumn, columns.first);
+            lastRow     = qMax(lastRow, row);
+            lastColumn  = qMax(lastColumn, columns.last);
+        }
+    }
 };
 
 class WorksheetPrivate : public AbstractSheetPrivate
@@ -190,13 +310,24 @@ public:
     WorksheetPrivate(Worksheet *p, Worksheet::CreateFlag flag);
     ~WorksheetPrivate();
 
+    bool canKeepSourceXml() const override { return !uncalculatedFormulas; }
+
 public:
     int checkDimensions(int row, int col, bool ignore_row = false, bool ignore_col = false);
     Format cellFormat(int row, int col) const;
+    QString formulaText(const CellFormula &formula, int row, int column) const;
+    void cellWritten(int row, int column);
+    std::shared_ptr<Cell> detachCell(int row, int column);
+    void recalculateFormulas() const;
     QString generateDimensionString() const;
     void calculateSpans() const;
+    QList<int> populatedRows() const;
     void splitColsInfo(int colFirst, int colLast);
     void validateDimension();
+    const RangeIndex &indexedMerges() const;
+    bool isHiddenByMerge(int row, int column) const;
+    const RangeIndex &indexedDataValidations() const;
+    const RangeIndex &indexedConditionalFormattings() const;
 
     void saveXmlSheetData(QXmlStreamWriter &writer) const;
     void saveXmlCellData(QXmlStreamWriter &writer,
@@ -222,12 +353,16 @@ public:
     QList<std::shared_ptr<XlsxRowInfo>> getRowInfoList(int rowFirst, int rowLast);
     QList<std::shared_ptr<XlsxColumnInfo>> getColumnInfoList(int colFirst, int colLast);
     QList<int> getColumnIndexes(int colFirst, int colLast);
+    const XlsxColumnInfo *columnInfo(int column) const;
+    const XlsxRowInfo *rowInfo(int row) const;
     bool isColumnRangeValid(int colFirst, int colLast);
 
     SharedStrings *sharedStrings() const;
 
 public:
     CellTable cellTable;
+    // the cells may be shared with copies of this sheet, see Worksheet::copy()
+    mutable bool cellsShared{false};
 
     QHash<int, QHash<int, QString>> comments;
     QHash<int, QHash<int, std::shared_ptr<XlsxHyperlinkData>>> urlTable;
@@ -238,8 +373,19 @@ public:
 
     QList<DataValidation> dataValidationsList;
     QList<ConditionalFormatting> conditionalFormattingList;
+    // cell lookup over the three lists above, caught up on the next query
+    mutable RangeIndex mergeIndex;
+    mutable RangeIndex dataValidationIndex;
+    mutable RangeIndex conditionalFormattingIndex;
 
     QHash<int, CellFormula> sharedFormulaMap; // shared formula map
+    // tokenised root formulas, built on first read of a dependent cell
+    mutable QHash<int, SharedFormulaTemplate> sharedFormulaTemplates;
+    // dependency graph of the formulas, built on the first write or save
+    mutable std::unique_ptr<FormulaEngine> formulaEngine;
+    // loaded formulas flagged ca or without a cached value, which get their
+    // results on save, so the loaded xml can not be saved back as is
+    bool uncalculatedFormulas{false};
 
     CellRange dimension;
 
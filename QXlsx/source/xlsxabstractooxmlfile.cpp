@@ -48,6 +48,10 @@ AbstractOOXmlFile::~AbstractOOXmlFile()
 
 QByteArray AbstractOOXmlFile::saveToXmlData() const
 {
+    Q_D(const AbstractOOXmlFile);
+    if (!d->sourceXml.isNull())
+        return d->sourceXml;
+
     QByteArray data;
     QBuffer buffer(&data);
     buffer.open(QIODevice::WriteOnly);
@@ -65,6 +69,36 @@ bool AbstractOOXmlFile::loadFromXmlData(const QByteArray &data)
     return loadFromXmlFile(&buffer);
 }
 
+/*!
+ * \internal
+ *
+ * Remembers the \a xml this part was loaded from. Until markModified() is
+ * called, saveToXmlData() returns it instead of serialising the part again.
+ */
+void AbstractOOXmlFile::setSourceXml(const QByteArray &xml)
+{
+    Q_D(AbstractOOXmlFile);
+    d->sourceXml = xml;
+}
+
+/*!
+ * \internal
+ */
+void AbstractOOXmlFile::markModified()
+{
+    Q_D(AbstractOOXmlFile);
+    d->sourceXml = QByteArray();
+}
+
+/*!
+ * \internal
+ */
+bool AbstractOOXmlFile::isModified() const
+{
+    Q_D(const AbstractOOXmlFile);
+    return d->sourceXml.isNull();
+}
+
 /*!
  * \internal
  */
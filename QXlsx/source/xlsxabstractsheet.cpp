@@ -18,6 +18,35 @@ AbstractSheetPrivate::~AbstractSheetPrivate()
 {
 }
 
+/*
+ * Loads the sheet from \a xml, keeping the xml when keepSourceXml is set
+ * and it is still up to date after loading.
+ */
+bool AbstractSheetPrivate::loadFromXml(const QByteArray &xml)
+{
+    Q_Q(AbstractSheet);
+    if (!q->loadFromXmlData(xml))
+        return false;
+    if (keepSourceXml && canKeepSourceXml())
+        q->setSourceXml(xml);
+    return true;
+}
+
+/*
+ * Parses the raw xml of a sheet whose loading was deferred. This is also
+ * where its shared string references get counted.
+ */
+void AbstractSheetPrivate::loadDeferred()
+{
+    if (!deferred)
+        return;
+
+    deferred             = false;
+    const QByteArray xml = deferredXml;
+    deferredXml.clear();
+    loadFromXml(xml);
+}
+
 /*!
   \class AbstractSheet
   \inmodule QtXlsx
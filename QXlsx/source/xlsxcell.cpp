@@ -24,7 +24,7 @@ CellPrivate::CellPrivate(Cell *p)
 }
 
 CellPrivate::CellPrivate(const CellPrivate *const cp)
-    : parent(cp->parent)
+    : workbook(cp->workbook)
     , cellType(cp->cellType)
     , value(cp->value)
     , formula(cp->formula)
@@ -66,7 +66,7 @@ Cell::Cell(const QVariant &data,
     d_ptr->value       = data;
     d_ptr->cellType    = type;
     d_ptr->format      = format;
-    d_ptr->parent      = parent;
+    d_ptr->workbook    = parent ? parent->workbook() : nullptr;
     d_ptr->styleNumber = styleIndex;
 }
 
@@ -278,7 +278,7 @@ QDateTime Cell::dateTime() const
         if (!isDateTime())
                 return QDateTime();
 
-        return datetimeFromNumber(d->value.toDouble(), d->parent->workbook()->isDate1904());
+        return datetimeFromNumber(d->value.toDouble(), d->workbook->isDate1904());
 }
 */
 QVariant Cell::dateTime() const
@@ -293,7 +293,7 @@ QVariant Cell::dateTime() const
 
     QVariant ret;
     double dValue   = d->value.toDouble();
-    bool isDate1904 = d->parent->workbook()->isDate1904();
+    bool isDate1904 = d->workbook && d->workbook->isDate1904();
     ret             = datetimeFromNumber(dValue, isDate1904);
     return ret;
 }
@@ -3,10 +3,10 @@
 #include "xlsxcellrange.h"
 
 #include "xlsxcellreference.h"
+#include "xlsxutility_p.h"
 
 #include <QPoint>
 #include <QString>
-#include <QStringList>
 
 QT_BEGIN_NAMESPACE_XLSX
 
@@ -73,20 +73,32 @@ CellRange::CellRange(const char *range)
 
 void CellRange::init(const QString &range)
 {
-    QStringList rs = range.split(QLatin1Char(':'));
-    if (rs.size() == 2) {
-        CellReference start(rs[0]);
-        CellReference end(rs[1]);
-        top    = start.row();
-        left   = start.column();
-        bottom = end.row();
-        right  = end.column();
+    // "A1:B2", or a single cell "A1". Unparsable parts leave -1 like an invalid CellReference.
+    int colon  = -1;
+    int colons = 0;
+    for (int i = 0; i < range.size(); ++i) {
+        if (range.at(i) == QLatin1Char(':')) {
+            if (colon < 0)
+                colon = i;
+            ++colons;
+        }
+    }
+
+    auto parse = [](QStringView part, int *row, int *column) {
+        if (!parseCellRef(part, row, column)) {
+            *row    = -1;
+            *column = -1;
+        }
+    };
+
+    const QStringView text(range);
+    if (colons == 1) {
+        parse(text.left(colon), &top, &left);
+        parse(text.mid(colon + 1), &bottom, &right);
     } else {
-        CellReference p(rs[0]);
-        top    = p.row();
-        left   = p.column();
-        bottom = p.row();
-        right  = p.column();
+        parse(colons ? text.left(colon) : text, &top, &left);
+        bottom = top;
+        right  = left;
     }
 }
 
@@ -117,14 +129,14 @@ QString CellRange::toString(bool row_abs, bool col_abs) const
     if (!isValid())
         return QString();
 
-    if (left == right && top == bottom) {
-        // Single cell
-        return CellReference(top, left).toString(row_abs, col_abs);
+    const int flags = (col_abs ? 0x01 : 0) | (row_abs ? 0x02 : 0);
+    QChar buffer[2 * CellRefBufferSize + 1];
+    int length = writeCellRef(buffer, top, left, flags);
+    if (left != right || top != bottom) {
+        buffer[length++] = QLatin1Char(':');
+        length += writeCellRef(buffer + length, bottom, right, flags);
     }
-
-    QString cell_1 = CellReference(top, left).toString(row_abs, col_abs);
-    QString cell_2 = CellReference(bottom, right).toString(row_abs, col_abs);
-    return cell_1 + QLatin1String(":") + cell_2;
+    return QString(buffer, length);
 }
 
 /*!
@@ -2,6 +2,7 @@
 
 #include "xlsxdocument.h"
 
+#include "xlsxabstractsheet_p.h"
 #include "xlsxchart.h"
 #include "xlsxcontenttypes_p.h"
 #include "xlsxdocpropsapp_p.h"
@@ -17,6 +18,7 @@
 #include "xlsxworkbook.h"
 #include "xlsxworkbook_p.h"
 #include "xlsxworksheet.h"
+#include "xlsxworksheet_p.h"
 #include "xlsxzipreader_p.h"
 #include "xlsxzipwriter_p.h"
 
@@ -168,8 +170,9 @@ void DocumentPrivate::init()
         workbook = std::shared_ptr<Workbook>(new Workbook(Workbook::F_NewFromScratch));
 }
 
-bool DocumentPrivate::loadPackage(QIODevice *device)
+bool DocumentPrivate::loadPackage(QIODevice *device, Document::LoadOptions options)
 {
+    const bool keepSourceXml = options.testFlag(Document::KeepSourceXml);
     Q_Q(Document);
     ZipReader zipReader(device);
     QStringList filePaths = zipReader.filePaths();
@@ -249,7 +252,9 @@ bool DocumentPrivate::loadPackage(QIODevice *device)
         }
 
         std::shared_ptr<Styles> styles(new Styles(Styles::F_LoadFromExists));
-        styles->loadFromXmlData(zipReader.fileData(path));
+        const QByteArray xml = zipReader.fileData(path);
+        if (styles->loadFromXmlData(xml) && keepSourceXml && !xml.isEmpty())
+            styles->setSourceXml(xml);
         workbook->d_func()->styles = styles;
     }
 
@@ -259,8 +264,11 @@ bool DocumentPrivate::loadPackage(QIODevice *device)
     if (!rels_sharedStrings.isEmpty()) {
         // In normal case this should be sharedStrings.xml which in xl
         QString name = rels_sharedStrings[0].target;
-        QString path = xlworkbook_Dir + QLatin1String("/") + name;
-        workbook->d_func()->sharedStrings->loadFromXmlData(zipReader.fileData(path));
+        QString path                 = xlworkbook_Dir + QLatin1String("/") + name;
+        SharedStrings *sharedStrings = workbook->d_func()->sharedStrings.get();
+        const QByteArray xml         = zipReader.fileData(path);
+        if (sharedStrings->loadFromXmlData(xml) && keepSourceXml && !xml.isEmpty())
+            sharedStrings->setSourceXml(xml);
     }
 
     // load theme
@@ -275,13 +283,28 @@ bool DocumentPrivate::loadPackage(QIODevice *device)
 
     // load sheets
     for (int i = 0; i < workbook->sheetCount(); ++i) {
-        AbstractSheet *sheet = workbook->sheet(i);
+        AbstractSheet *sheet = workbook->d_func()->sheets[i].get();
         QString strFilePath  = sheet->filePath();
         QString rel_path     = getRelFilePath(strFilePath);
         // If the .rel file exists, load it.
         if (zipReader.filePaths().contains(rel_path))
             sheet->relationships()->loadFromXmlData(zipReader.fileData(rel_path));
-        sheet->loadFromXmlData(zipReader.fileData(sheet->filePath()));
+
+        // A worksheet that refers to no other part of the package can be
+        // kept as raw xml until it is accessed with LoadSheetsOnDemand, and
+        // with KeepSourceXml written back unchanged while it is not modified.
+        const QByteArray xml     = zipReader.fileData(sheet->filePath());
+        const bool selfContained = sheet->sheetType() == AbstractSheet::ST_WorkSheet &&
+                                   sheet->relationships()->hasOnlyExternalTargets() &&
+                                   !xml.isEmpty();
+        AbstractSheetPrivate *sheet_d = sheet->d_func();
+        sheet_d->keepSourceXml        = selfContained && keepSourceXml;
+        if (selfContained && options.testFlag(Document::LoadSheetsOnDemand)) {
+            sheet_d->deferred    = true;
+            sheet_d->deferredXml = xml;
+            continue;
+        }
+        sheet_d->loadFromXml(xml);
     }
 
     // load external links
@@ -346,8 +369,9 @@ bool DocumentPrivate::savePackage(QIODevice *device) const
         contentTypes->addWorksheetName(QStringLiteral("sheet%1").arg(i + 1));
         docPropsApp.addPartTitle(sheet->sheetName());
 
+        const AbstractSheetPrivate *sheet_d = sheet->d_func();
         zipWriter.addFile(QStringLiteral("xl/worksheets/sheet%1.xml").arg(i + 1),
-                          sheet->saveToXmlData());
+                          sheet_d->deferred ? sheet_d->deferredXml : sheet->saveToXmlData());
 
         Relationships *rel = sheet->relationships();
         if (!rel->isEmpty())
@@ -503,56 +527,32 @@ bool DocumentPrivate::saveCsv(QString mainCSVFileName) const
         // Fix bug: Invalid function call order. I am sorry.
         const QVector<CellLocation> clList = wsheet->getFullCells(&maxRow, &maxCol);
 
-        QVector<QVector<QString>> cellValues;
-        for (int rc = 0; rc < maxRow; rc++) {
-            QVector<QString> tempValue;
-
-            for (int cc = 0; cc < maxCol; cc++) {
-                tempValue.push_back(QString{});
-            }
-
-            cellValues.push_back(tempValue);
-        }
-
-        // const QVector<CellLocation> clList = wsheet->getFullCells(&maxRow, &maxCol);
-        for (const auto &cl : clList) {
-            int row = cl.row - 1;
-            int col = cl.col - 1;
-
-            std::shared_ptr<Cell> ptrCell = cl.cell; // cell pointer
-            QVariant var                  = ptrCell->value();
-            QString str                   = var.toString();
-
-            cellValues[row][col] = str;
-        }
-
-        // TODO:
-        //  (1) save as csv file name (using { mainCSVFileName + strSheetName })
-
         QString csvFileName = mainCSVFileName + u'_' + strSheetName + QLatin1String(".csv");
         QFile csvFile(csvFileName);
         if (!csvFile.open(QIODevice::WriteOnly)) {
             continue;
         }
 
-        //  (2) save sheet values
-        //     such as  A,,B,,,,C,,,D,,
-
-        for (int rc = 0; rc < maxRow; rc++) {
-            for (int cc = 0; cc < maxCol; cc++) {
-
-                QString cellData = cellValues[rc][cc];
-
-                if (cellData.size() >= 0) {
-                    csvFile.write(cellData.toUtf8()); // cell data
-                }
-
-                csvFile.write(","); // delimeter
+        // save sheet values row by row, such as  A,,B,,,,C,,,D,,
+        // clList is sorted by row and column, so every line is built in one pass
+        // instead of materialising a maxRow x maxCol grid first.
+        auto cellIt = clList.constBegin();
+        QByteArray line;
+        for (int row = 1; row <= maxRow; row++) {
+            line.clear();
+            int col = 1;
+            for (; cellIt != clList.constEnd() && cellIt->row == row; ++cellIt) {
+                for (; col < cellIt->col; col++)
+                    line += ',';
+                line += cellIt->cell->value().toString().toUtf8(); // cell data
+                line += ',';                                        // delimeter
+                col++;
             }
+            for (; col <= maxCol; col++)
+                line += ',';
+            line += '\n'; // CR
 
-            csvFile.write("\n"); // CR
-
-            csvFile.flush();
+            csvFile.write(line);
         }
 
         // file.flush();
@@ -684,6 +684,39 @@ Document::Document(const QString &name, QObject *parent)
     d_ptr->init();
 }
 
+/*!
+ * \overload
+ * Try to open an existing xlsx document named \a name.
+ * With LoadSheetsOnDemand in \a options, worksheets are parsed on first access
+ * through sheet(), currentSheet() or the workbook, and the ones never
+ * accessed are saved back unchanged. Their shared string references are
+ * only counted once they are parsed, so the count attribute saved in
+ * sharedStrings.xml leaves out sheets that were never accessed; strings
+ * are never dropped from the table, so the indexes they use stay valid.
+ * With KeepSourceXml, the xml of the styles, the shared strings and the
+ * worksheets that refer to no other part is kept while the document is
+ * open, and the ones not modified are saved from it instead of being
+ * serialised again. This trades memory for faster, lossless saves.
+ * The \a parent argument is passed to QObject's constructor.
+ */
+Document::Document(const QString &name, LoadOptions options, QObject *parent)
+    : QObject(parent)
+    , d_ptr(new DocumentPrivate(this))
+{
+    d_ptr->packageName = name;
+
+    if (QFile::exists(name)) {
+        QFile xlsx(name);
+        if (xlsx.open(QFile::ReadOnly)) {
+            if (!d_ptr->loadPackage(&xlsx, options)) {
+                // NOTICE: failed to load package
+            }
+        }
+    }
+
+    d_ptr->init();
+}
+
 /*!
  * \overload
  * Try to open an existing xlsx document from \a device.
@@ -701,6 +734,24 @@ Document::Document(QIODevice *device, QObject *parent)
     d_ptr->init();
 }
 
+/*!
+ * \overload
+ * Try to open an existing xlsx document from \a device, loading it as
+ * given by \a options.
+ * The \a parent argument is passed to QObject's constructor.
+ */
+Document::Document(QIODevice *device, LoadOptions options, QObject *parent)
+    : QObject(parent)
+    , d_ptr(new DocumentPrivate(this))
+{
+    if (device && device->isReadable()) {
+        if (!d_ptr->loadPackage(device, options)) {
+            // NOTICE: failed to load package
+        }
+    }
+    d_ptr->init();
+}
+
 /*!
         \overload
 
@@ -761,6 +812,19 @@ int Document::insertImage(int row, int column, const QImage &image)
     return 0;
 }
 
+/*!
+ * \overload
+ * Insert the encoded PNG, JPEG, GIF or BMP image \a bytes to current active
+ * worksheet at the position \a row, \a column, without re-encoding it.
+ */
+int Document::insertImage(int row, int column, const QByteArray &bytes)
+{
+    if (Worksheet *sheet = currentWorksheet())
+        return sheet->insertImage(row, column, bytes);
+
+    return 0;
+}
+
 bool Document::getImage(int imageIndex, QImage &img)
 {
     if (Worksheet *sheet = currentWorksheet())
@@ -1444,32 +1508,53 @@ bool Document::changeimage(int filenoinmidea, QString newfile)
 QMap<int, int> Document::getMaximalColumnWidth(int firstRow, int lastRow)
 {
     const int defaultPixelSize = 11; // Default font pixel size of excel?
-    int maxRows                = -1;
-    int maxCols                = -1;
     QMap<int, int> colWidth;
-    if (!currentWorksheet())
+    const Worksheet *sheet = currentWorksheet();
+    if (!sheet)
         return colWidth;
-    QVector<CellLocation> cellLocation = currentWorksheet()->getFullCells(&maxRows, &maxCols);
-
-    for (int i = 0; i < cellLocation.size(); i++) {
-        int col = cellLocation.at(i).col;
-        int row = cellLocation.at(i).row;
-        int fs  = cellLocation.at(i).cell->format().fontSize();
-        if (fs <= 0) {
-            fs = defaultPixelSize;
-        }
 
-        //        QString str = cellLocation.at(i).cell.data()->value().toString();
-        QString str = read(row, col).toString();
+    const CellTable &cellTable = sheet->d_func()->cellTable;
+    const CellRange bounds     = cellTable.bounds();
+    if (!bounds.isValid())
+        return colWidth;
+    firstRow = qMax(firstRow, bounds.firstRow());
+    lastRow  = qMin(lastRow, bounds.lastRow());
+    if (firstRow > lastRow)
+        return colWidth;
+
+    // The result is a map, so rows and cells are visited in hash order and
+    // only the rows within [firstRow, lastRow] are looked at.
+    auto measureRow = [&](int row, const QHash<int, std::shared_ptr<Cell>> &columns) {
+        for (auto it = columns.constBegin(); it != columns.constEnd(); ++it) {
+            const int col = it.key();
+            int fs        = it.value()->format().fontSize();
+            if (fs <= 0) {
+                fs = defaultPixelSize;
+            }
+
+            QString str = sheet->read(row, col).toString();
 
-        double w = str.length() * double(fs) / defaultPixelSize +
-                   1; // width not perfect, but works reasonably well
+            double w = str.length() * double(fs) / defaultPixelSize +
+                       1; // width not perfect, but works reasonably well
 
-        if ((row >= firstRow) && (row <= lastRow)) {
             if (w > colWidth.value(col)) {
                 colWidth.insert(col, int(w));
             }
         }
+    };
+
+    if (qint64(lastRow) - firstRow + 1 <= cellTable.cells.size()) {
+        for (int row = firstRow; row <= lastRow; ++row) {
+            auto rowIt = cellTable.cells.constFind(row);
+            if (rowIt != cellTable.cells.constEnd())
+                measureRow(row, *rowIt);
+        }
+    } else {
+        for (auto rowIt = cellTable.cells.constBegin(); rowIt != cellTable.cells.constEnd();
+             ++rowIt) {
+            if (rowIt.key() >= firstRow && rowIt.key() <= lastRow)
+                measureRow(rowIt.key(), *rowIt);
+        }
     }
 
     return colWidth;
@@ -1594,9 +1679,10 @@ bool Document::read_sheet_sax(int sheet_index,
     }
 
            // sheet XML path: workbook already has filePath (actual path determined by relationship (rels))
-    AbstractSheet *abs_sheet = d_ptr->workbook->sheet(sheet_index);
-    if (!abs_sheet)
+    // Only the path is needed, so a sheet loaded on demand stays unparsed
+    if (sheet_index < 0 || sheet_index >= d_ptr->workbook->sheetCount())
         return false;
+    AbstractSheet *abs_sheet = d_ptr->workbook->d_func()->sheets[sheet_index].get();
 
     const QString sheet_path = abs_sheet->filePath();
     const QByteArray sheet_xml = zip.fileData(sheet_path);
@@ -67,9 +67,19 @@ void DrawingAnchor::setObjectPicture(const QImage &img)
     buffer.open(QIODevice::WriteOnly);
     img.save(&buffer, "PNG");
 
+    setObjectPicture(ba, QStringLiteral("png"), QStringLiteral("image/png"));
+}
+
+/*
+ * Uses the already encoded image \a bytes as they are. Identical images
+ * share one media file in the workbook.
+ */
+void DrawingAnchor::setObjectPicture(const QByteArray &bytes,
+                                     const QString &suffix,
+                                     const QString &mimeType)
+{
     m_pictureFile =
-        std::make_shared<MediaFile>(ba, QStringLiteral("png"), QStringLiteral("image/png"));
-    m_drawing->workbook->addMediaFile(m_pictureFile);
+        m_drawing->workbook->addMediaFile(std::make_shared<MediaFile>(bytes, suffix, mimeType));
 
     m_objectType = Picture;
 }
@@ -79,8 +89,8 @@ bool DrawingAnchor::getObjectPicture(QImage &img)
     if (m_pictureFile == nullptr)
         return false;
 
-    bool ret = img.loadFromData(m_pictureFile->contents());
-    return ret;
+    img = m_pictureFile->image();
+    return !img.isNull();
 }
 
 //{{ liufeijin
@@ -91,9 +101,8 @@ void DrawingAnchor::setObjectShape(const QImage &img)
     buffer.open(QIODevice::WriteOnly);
     img.save(&buffer, "PNG");
 
-    m_pictureFile =
-        std::make_shared<MediaFile>(ba, QStringLiteral("png"), QStringLiteral("image/png"));
-    m_drawing->workbook->addMediaFile(m_pictureFile);
+    m_pictureFile = m_drawing->workbook->addMediaFile(
+        std::make_shared<MediaFile>(ba, QStringLiteral("png"), QStringLiteral("image/png")));
 
     m_objectType = Shape;
 }
@@ -381,16 +390,8 @@ void DrawingAnchor::loadXmlObjectPicture(QXmlStreamReader &reader)
                 const auto parts = splitPath(m_drawing->filePath());
                 QString path     = QDir::cleanPath(parts.first() + QLatin1String("/") + name);
 
-                bool exist     = false;
-                const auto mfs = m_drawing->workbook->mediaFiles();
-                for (const auto &mf : mfs) {
-                    if (mf->fileName() == path) {
-                        // already exist
-                        exist         = true;
-                        m_pictureFile = mf;
-                    }
-                }
-                if (!exist) {
+                m_pictureFile = m_drawing->workbook->mediaFile(path);
+                if (!m_pictureFile) {
                     m_pictureFile = std::make_shared<MediaFile>(path);
                     m_drawing->workbook->addMediaFile(m_pictureFile, true);
                 }
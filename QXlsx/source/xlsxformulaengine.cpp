@@ -0,0 +1,1227 @@
+// xlsxformulaengine.cpp
+
+#include "xlsxcell.h"
+#include "xlsxcell_p.h"
+#include "xlsxcellformula.h"
+#include "xlsxcellformula_p.h"
+#include "xlsxformulaengine_p.h"
+#include "xlsxutility_p.h"
+#include "xlsxworkbook.h"
+#include "xlsxworksheet_p.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <QDebug>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+namespace {
+
+using Area    = FormulaEngine::Area;
+using Op      = FormulaEngine::Op;
+using Program = FormulaEngine::Program;
+using Value   = FormulaEngine::Value;
+
+const int kRowMax    = 1048576;
+const int kColumnMax = 16384;
+
+// Ranges spanning more columns than this are not bucketed by column, but
+// by bands of rows unless they also span more than kMaxRowBands bands.
+const int kColumnBucketSpan = 16;
+const int kRowBandHeight    = 32;
+const int kMaxRowBands      = 32;
+
+int rowBand(int row)
+{
+    return (row - 1) / kRowBandHeight;
+}
+
+bool isNarrow(const Area &area)
+{
+    return area.lastColumn - area.firstColumn < kColumnBucketSpan;
+}
+
+bool isShort(const Area &area)
+{
+    return rowBand(area.lastRow) - rowBand(area.firstRow) < kMaxRowBands;
+}
+
+Value makeNumber(double number)
+{
+    Value value;
+    value.type   = Value::Number;
+    value.number = number;
+    return value;
+}
+
+Value makeBoolean(bool boolean)
+{
+    Value value;
+    value.type   = Value::Boolean;
+    value.number = boolean ? 1 : 0;
+    return value;
+}
+
+Value makeString(const QString &text)
+{
+    Value value;
+    value.type = Value::String;
+    value.text = text;
+    return value;
+}
+
+Value makeError(const QString &code)
+{
+    Value value;
+    value.type = Value::Error;
+    value.text = code;
+    return value;
+}
+
+Value valueError()
+{
+    return makeError(QStringLiteral("#VALUE!"));
+}
+
+/*
+ * Converts a scalar to a number the way Excel does for operators:
+ * blanks are 0, booleans are 0/1 and text must look like a number.
+ */
+bool toNumber(const Value &value, double *number, Value *error)
+{
+    switch (value.type) {
+    case Value::Number:
+    case Value::Boolean:
+        *number = value.number;
+        return true;
+    case Value::Empty:
+    case Value::Missing:
+        *number = 0;
+        return true;
+    case Value::String: {
+        bool ok = false;
+        *number = value.text.trimmed().toDouble(&ok);
+        if (ok)
+            return true;
+        *error = valueError();
+        return false;
+    }
+    case Value::Error:
+        *error = value;
+        return false;
+    default:
+        *error = valueError();
+        return false;
+    }
+}
+
+QString toText(const Value &value)
+{
+    switch (value.type) {
+    case Value::Number:
+        return QString::number(value.number, 'g', 15);
+    case Value::Boolean:
+        return value.number != 0 ? QStringLiteral("TRUE") : QStringLiteral("FALSE");
+    case Value::String:
+        return value.text;
+    default:
+        return QString();
+    }
+}
+
+/*
+ * Compares two non-error scalars. Blanks take the type of the other side,
+ * otherwise numbers < text < booleans and text compares case-insensitively.
+ */
+int compareValues(const Value &lhs, const Value &rhs)
+{
+    auto rank = [](Value::Type type) {
+        return type == Value::Number ? 0 : type == Value::String ? 1 : 2;
+    };
+
+    Value a = lhs;
+    Value b = rhs;
+    if (a.type == Value::Empty || a.type == Value::Missing)
+        a = b.type == Value::String ? makeString(QString())
+                                    : (b.type == Value::Boolean ? makeBoolean(false) : makeNumber(0));
+    if (b.type == Value::Empty || b.type == Value::Missing)
+        b = a.type == Value::String ? makeString(QString())
+                                    : (a.type == Value::Boolean ? makeBoolean(false) : makeNumber(0));
+
+    if (rank(a.type) != rank(b.type))
+        return rank(a.type) < rank(b.type) ? -1 : 1;
+    if (a.type == Value::String)
+        return a.text.compare(b.text, Qt::CaseInsensitive);
+    if (a.number == b.number)
+        return 0;
+    return a.number < b.number ? -1 : 1;
+}
+
+// Parses a case-insensitive A1 reference into a cell position inside the sheet limits.
+bool parseA1(const QChar *data, int length, int *row, int *column)
+{
+    // Formulas typed by users may be lower case, the codec only takes upper case.
+    QChar upper[CellRefBufferSize];
+    if (length <= 0 || length > CellRefBufferSize)
+        return false;
+    for (int i = 0; i < length; ++i)
+        upper[i] = data[i].unicode() < 128 ? data[i].toUpper() : QChar();
+
+    int r   = 0;
+    int col = 0;
+    if (!parseCellRef(QStringView(upper, length), &r, &col))
+        return false;
+    if (r < 1 || r > kRowMax || col < 1 || col > kColumnMax)
+        return false;
+
+    *row    = r;
+    *column = col;
+    return true;
+}
+
+} // namespace
+
+/*
+ * Recursive descent parser producing a postfix program. Precedence, from
+ * loosest to tightest: comparison, &, + -, * /, ^, unary -, %, ':'.
+ * Returns false for anything outside the supported subset.
+ */
+class FormulaEngine::Parser
+{
+public:
+    Parser(const QString &formula, Program &program)
+        : text(formula)
+        , data(formula.constData())
+        , size(formula.size())
+        , program(program)
+    {
+    }
+
+    bool parse()
+    {
+        if (!parseComparison())
+            return false;
+        skipSpaces();
+        return pos == size;
+    }
+
+private:
+    void skipSpaces()
+    {
+        while (pos < size && data[pos].isSpace())
+            ++pos;
+    }
+
+    bool match(char ch)
+    {
+        skipSpaces();
+        if (pos < size && data[pos] == QLatin1Char(ch)) {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+
+    bool match(char first, char second)
+    {
+        skipSpaces();
+        if (pos + 1 < size && data[pos] == QLatin1Char(first) &&
+            data[pos + 1] == QLatin1Char(second)) {
+            pos += 2;
+            return true;
+        }
+        return false;
+    }
+
+    void emitOp(OpCode code, double number = 0, int argc = 0, quint8 function = 0)
+    {
+        program.ops.append(Op{code, function, argc, number, Area{0, 0, 0, 0}});
+    }
+
+    bool parseComparison()
+    {
+        if (!parseConcat())
+            return false;
+        for (;;) {
+            OpCode code;
+            if (match('<', '='))
+                code = LessEqual;
+            else if (match('>', '='))
+                code = GreaterEqual;
+            else if (match('<', '>'))
+                code = NotEqual;
+            else if (match('<'))
+                code = Less;
+            else if (match('>'))
+                code = Greater;
+            else if (match('='))
+                code = Equal;
+            else
+                return true;
+            if (!parseConcat())
+                return false;
+            emitOp(code);
+        }
+    }
+
+    bool parseConcat()
+    {
+        if (!parseAdditive())
+            return false;
+        while (match('&')) {
+            if (!parseAdditive())
+                return false;
+            emitOp(Concat);
+        }
+        return true;
+    }
+
+    bool parseAdditive()
+    {
+        if (!parseTerm())
+            return false;
+        for (;;) {
+            OpCode code;
+            if (match('+'))
+                code = Add;
+            else if (match('-'))
+                code = Subtract;
+            else
+                return true;
+            if (!parseTerm())
+                return false;
+            emitOp(code);
+        }
+    }
+
+    bool parseTerm()
+    {
+        if (!parsePower())
+            return false;
+        for (;;) {
+            OpCode code;
+            if (match('*'))
+                code = Multiply;
+            else if (match('/'))
+                code = Divide;
+            else
+                return true;
+            if (!parsePower())
+                return false;
+            emitOp(code);
+        }
+    }
+
+    bool parsePower()
+    {
+        if (!parseUnary())
+            return false;
+        while (match('^')) {
+            if (!parseUnary())
+                return false;
+            emitOp(Power);
+        }
+        return true;
+    }
+
+    bool parseUnary()
+    {
+        // In Excel negation binds tighter than ^, so -2^2 is 4.
+        if (match('-')) {
+            if (!parseUnary())
+                return false;
+            emitOp(Negate);
+            return true;
+        }
+        if (match('+'))
+            return parseUnary();
+
+        if (!parsePrimary())
+            return false;
+        while (match('%'))
+            emitOp(Percent);
+        return true;
+    }
+
+    bool parsePrimary()
+    {
+        skipSpaces();
+        if (pos >= size)
+            return false;
+
+        const QChar ch = data[pos];
+        if (ch == QLatin1Char('(')) {
+            ++pos;
+            return parseComparison() && match(')');
+        }
+        if (ch == QLatin1Char('"'))
+            return parseString();
+        if (ch.isDigit() ||
+            (ch == QLatin1Char('.') && pos + 1 < size && data[pos + 1].isDigit()))
+            return parseNumber();
+        if (ch == QLatin1Char('#'))
+            return parseErrorLiteral();
+        if (ch == QLatin1Char('$') || ch == QLatin1Char('_') || ch.isLetter())
+            return parseName();
+        return false;
+    }
+
+    bool parseString()
+    {
+        QString value;
+        ++pos; // opening quote
+        while (pos < size) {
+            if (data[pos] == QLatin1Char('"')) {
+                if (pos + 1 < size && data[pos + 1] == QLatin1Char('"')) {
+                    value.append(QLatin1Char('"'));
+                    pos += 2;
+                    continue;
+                }
+                ++pos;
+                program.strings.append(value);
+                emitOp(PushString, 0, program.strings.size() - 1);
+                return true;
+            }
+            value.append(data[pos++]);
+        }
+        return false; // unterminated
+    }
+
+    bool parseNumber()
+    {
+        const int start = pos;
+        while (pos < size && data[pos].isDigit())
+            ++pos;
+        if (pos < size && data[pos] == QLatin1Char('.')) {
+            ++pos;
+            while (pos < size && data[pos].isDigit())
+                ++pos;
+        }
+        if (pos < size && (data[pos] == QLatin1Char('E') || data[pos] == QLatin1Char('e'))) {
+            int exponent = pos + 1;
+            if (exponent < size &&
+                (data[exponent] == QLatin1Char('+') || data[exponent] == QLatin1Char('-')))
+                ++exponent;
+            if (exponent < size && data[exponent].isDigit()) {
+                pos = exponent;
+                while (pos < size && data[pos].isDigit())
+                    ++pos;
+            }
+        }
+
+        bool ok             = false;
+        const double number = text.mid(start, pos - start).toDouble(&ok);
+        if (!ok)
+            return false;
+        emitOp(PushNumber, number);
+        return true;
+    }
+
+    bool parseErrorLiteral()
+    {
+        static const char *const errors[] = {
+            "#DIV/0!", "#N/A", "#NAME?", "#NULL!", "#NUM!", "#REF!", "#VALUE!"};
+        for (const char *error : errors) {
+            const QLatin1String code(error);
+            if (text.mid(pos, code.size()).compare(code, Qt::CaseInsensitive) == 0) {
+                pos += code.size();
+                program.strings.append(QString(code));
+                emitOp(PushError, 0, program.strings.size() - 1);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    int scanName()
+    {
+        const int start = pos;
+        while (pos < size && (data[pos].isLetterOrNumber() || data[pos] == QLatin1Char('_') ||
+                              data[pos] == QLatin1Char('.') || data[pos] == QLatin1Char('$')))
+            ++pos;
+        return start;
+    }
+
+    bool parseName()
+    {
+        const int start  = scanName();
+        const int length = pos - start;
+
+        if (pos < size && data[pos] == QLatin1Char('('))
+            return parseCall(text.mid(start, length).toUpper());
+        if (pos < size && data[pos] == QLatin1Char('!'))
+            return false; // other sheet
+
+        int row    = 0;
+        int column = 0;
+        if (parseA1(data + start, length, &row, &column)) {
+            Area area{row, column, row, column};
+            if (pos < size && data[pos] == QLatin1Char(':')) {
+                ++pos;
+                const int end = scanName();
+                int row2      = 0;
+                int column2   = 0;
+                if (!parseA1(data + end, pos - end, &row2, &column2))
+                    return false; // whole rows / columns are not supported
+                area = Area{qMin(row, row2), qMin(column, column2), qMax(row, row2),
+                            qMax(column, column2)};
+            }
+            Op op{PushReference, 0, 0, 0, area};
+            program.ops.append(op);
+            return true;
+        }
+
+        const QString name = text.mid(start, length);
+        if (name.compare(QLatin1String("TRUE"), Qt::CaseInsensitive) == 0) {
+            emitOp(PushBoolean, 1);
+            return true;
+        }
+        if (name.compare(QLatin1String("FALSE"), Qt::CaseInsensitive) == 0) {
+            emitOp(PushBoolean, 0);
+            return true;
+        }
+        return false; // defined names are not supported
+    }
+
+    bool parseCall(const QString &name)
+    {
+        quint8 function;
+        int minArgs = 1;
+        int maxArgs = 255;
+        if (name == QLatin1String("SUM")) {
+            function = Sum;
+        } else if (name == QLatin1String("COUNT")) {
+            function = Count;
+        } else if (name == QLatin1String("AVERAGE")) {
+            function = Average;
+        } else if (name == QLatin1String("MIN")) {
+            function = Min;
+        } else if (name == QLatin1String("MAX")) {
+            function = Max;
+        } else if (name == QLatin1String("IF")) {
+            function = If;
+            minArgs  = 2;
+            maxArgs  = 3;
+        } else {
+            return false;
+        }
+
+        ++pos; // '('
+        int argc = 0;
+        if (!match(')')) {
+            for (;;) {
+                skipSpaces();
+                if (pos < size && (data[pos] == QLatin1Char(',') || data[pos] == QLatin1Char(')')))
+                    emitOp(PushMissing);
+                else if (!parseComparison())
+                    return false;
+                ++argc;
+                if (match(','))
+                    continue;
+                if (match(')'))
+                    break;
+                return false;
+            }
+        }
+        if (argc < minArgs || argc > maxArgs)
+            return false;
+
+        emitOp(Call, 0, argc, function);
+        return true;
+    }
+
+    const QString &text;
+    const QChar *data;
+    int size;
+    int pos{0};
+    Program &program;
+};
+
+FormulaEngine::FormulaEngine(WorksheetPrivate *sheet)
+    : sheet(sheet)
+{
+}
+
+FormulaEngine::~FormulaEngine()
+{
+}
+
+/*
+ * Calls visit(row, column, cell) for the existing cells inside area,
+ * walking whichever of the area or the table is smaller.
+ */
+template <typename Visitor>
+void FormulaEngine::forEachCell(const Area &area, Visitor visit) const
+{
+    const auto &rows     = sheet->cellTable.cells;
+    const qint64 height  = qint64(area.lastRow) - area.firstRow + 1;
+    const qint64 width   = qint64(area.lastColumn) - area.firstColumn + 1;
+
+    auto visitRow = [&](int row, const QHash<int, std::shared_ptr<Cell>> &columns) {
+        if (width <= columns.size()) {
+            for (int column = area.firstColumn; column <= area.lastColumn; ++column) {
+                auto it = columns.constFind(column);
+                if (it != columns.constEnd())
+                    visit(row, column, it->get());
+            }
+        } else {
+            for (auto it = columns.constBegin(); it != columns.constEnd(); ++it) {
+                if (it.key() >= area.firstColumn && it.key() <= area.lastColumn)
+                    visit(row, it.key(), it->get());
+            }
+        }
+    };
+
+    if (height <= rows.size()) {
+        for (int row = area.firstRow; row <= area.lastRow; ++row) {
+            auto it = rows.constFind(row);
+            if (it != rows.constEnd())
+                visitRow(row, *it);
+        }
+    } else {
+        for (auto it = rows.constBegin(); it != rows.constEnd(); ++it) {
+            if (it.key() >= area.firstRow && it.key() <= area.lastRow)
+                visitRow(it.key(), *it);
+        }
+    }
+}
+
+/*
+ * Called after the cell (row, column) has been written. Recompiles the cell
+ * if it holds a formula and marks everything depending on it dirty.
+ */
+void FormulaEngine::cellChanged(int row, int column)
+{
+    ensureIndexed();
+
+    const quint64 key = keyOf(row, column);
+    auto it           = nodes.find(key);
+    if (it != nodes.end()) {
+        unlink(key, *it);
+        dirty.remove(key);
+        nodes.erase(it);
+    }
+
+    const auto cell = sheet->cellTable.cellAt(row, column);
+    if (cell && cell->hasFormula()) {
+        Node node;
+        if (compile(row, column, cell.get(), node)) {
+            node.dirty = true;
+            link(key, node);
+            nodes.insert(key, node);
+            dirty.insert(key);
+        }
+    }
+
+    markDependentsDirty(key);
+}
+
+/*
+ * Evaluates the dirty formulas, precedents first, and stores the results
+ * as the cached values of their cells.
+ */
+void FormulaEngine::recalculate()
+{
+    ensureIndexed();
+    if (dirty.isEmpty())
+        return;
+
+    // Iterative depth first search so that long chains cannot overflow the stack.
+    enum { Unvisited = 0, Visiting = 1, Done = 2 };
+    struct Frame
+    {
+        quint64 key;
+        QVector<quint64> precedents;
+        int next;
+    };
+
+    QVector<quint64> order;
+    order.reserve(dirty.size());
+    QVector<Frame> frames;
+
+    const QList<quint64> roots = dirty.values();
+    for (quint64 root : roots) {
+        auto rootIt = nodes.find(root);
+        if (rootIt->state != Unvisited)
+            continue;
+
+        rootIt->state = Visiting;
+        frames.append(Frame{root, {}, 0});
+        dirtyPrecedents(*rootIt, frames.last().precedents);
+
+        while (!frames.isEmpty()) {
+            Frame &frame = frames.last();
+            if (frame.next < frame.precedents.size()) {
+                const quint64 precedent = frame.precedents.at(frame.next++);
+                auto it                 = nodes.find(precedent);
+                if (it->state == Visiting) {
+                    // Every formula from the re-entered one up to this frame
+                    // is on the cycle.
+                    for (int i = frames.size() - 1; i >= 0; --i) {
+                        nodes.find(frames.at(i).key)->circular = true;
+                        if (frames.at(i).key == precedent)
+                            break;
+                    }
+                } else if (it->state == Unvisited) {
+                    it->state = Visiting;
+                    Frame next{precedent, {}, 0};
+                    dirtyPrecedents(*it, next.precedents);
+                    frames.append(next);
+                }
+            } else {
+                nodes.find(frame.key)->state = Done;
+                order.append(frame.key);
+                frames.removeLast();
+            }
+        }
+    }
+
+    bool circular = false;
+    for (quint64 key : order) {
+        auto it = nodes.find(key);
+        if (it->circular) {
+            circular = true;
+            store(rowOf(key), columnOf(key), makeNumber(0));
+        } else {
+            store(rowOf(key), columnOf(key), evaluate(*it));
+        }
+        it->dirty    = false;
+        it->circular = false;
+        it->state    = Unvisited;
+    }
+    dirty.clear();
+
+    if (circular)
+        qWarning("[xlsxformulaengine.cpp] circular reference found, formulas on the cycle set to 0");
+}
+
+/*
+ * Compiles every formula of the sheet the first time the engine is used.
+ * Formulas flagged for calculation or without a cached value start dirty.
+ */
+void FormulaEngine::ensureIndexed()
+{
+    if (indexed)
+        return;
+    indexed = true;
+
+    const auto &rows = sheet->cellTable.cells;
+    for (auto rowIt = rows.constBegin(); rowIt != rows.constEnd(); ++rowIt) {
+        for (auto it = rowIt->constBegin(); it != rowIt->constEnd(); ++it) {
+            const Cell *cell = it->get();
+            if (!cell->hasFormula())
+                continue;
+
+            Node node;
+            if (!compile(rowIt.key(), it.key(), cell, node))
+                continue;
+
+            const quint64 key = keyOf(rowIt.key(), it.key());
+            if (cell->d_ptr->formula.d->ca || !cell->d_ptr->value.isValid()) {
+                node.dirty = true;
+                dirty.insert(key);
+            }
+            link(key, node);
+            nodes.insert(key, node);
+        }
+    }
+
+    // Dirty formulas found during the scan dirty their dependents as well.
+    const QList<quint64> initial = dirty.values();
+    for (quint64 key : initial)
+        markDependentsDirty(key);
+}
+
+bool FormulaEngine::compile(int row, int column, const Cell *cell, Node &node) const
+{
+    const QString formula = sheet->formulaText(cell->d_ptr->formula, row, column);
+    if (formula.isEmpty())
+        return false;
+
+    Parser parser(formula, node.program);
+    if (!parser.parse())
+        return false;
+
+    for (const Op &op : node.program.ops) {
+        if (op.code != PushReference)
+            continue;
+        const Area &area = op.area;
+        if (area.firstRow == area.lastRow && area.firstColumn == area.lastColumn) {
+            const quint64 precedent = keyOf(area.firstRow, area.firstColumn);
+            if (!node.cells.contains(precedent))
+                node.cells.append(precedent);
+        } else {
+            node.ranges.append(area);
+        }
+    }
+    return true;
+}
+
+void FormulaEngine::link(quint64 key, const Node &node)
+{
+    for (quint64 precedent : node.cells)
+        cellDependents[precedent].append(key);
+
+    for (const Area &area : node.ranges) {
+        if (isNarrow(area)) {
+            for (int column = area.firstColumn; column <= area.lastColumn; ++column)
+                columnRanges[column].append(RangeLink{area, key});
+        } else if (isShort(area)) {
+            for (int band = rowBand(area.firstRow); band <= rowBand(area.lastRow); ++band)
+                rowBandRanges[band].append(RangeLink{area, key});
+        } else {
+            wideRanges.append(RangeLink{area, key});
+        }
+    }
+}
+
+void FormulaEngine::unlink(quint64 key, const Node &node)
+{
+    for (quint64 precedent : node.cells) {
+        auto it = cellDependents.find(precedent);
+        if (it == cellDependents.end())
+            continue;
+        it->removeAll(key);
+        if (it->isEmpty())
+            cellDependents.erase(it);
+    }
+
+    auto isLinkOf = [key](const RangeLink &link) { return link.formula == key; };
+    auto unlinkFrom = [&isLinkOf](QHash<int, QVector<RangeLink>> &buckets, int bucket) {
+        auto it = buckets.find(bucket);
+        if (it == buckets.end())
+            return;
+        it->erase(std::remove_if(it->begin(), it->end(), isLinkOf), it->end());
+        if (it->isEmpty())
+            buckets.erase(it);
+    };
+    for (const Area &area : node.ranges) {
+        if (isNarrow(area)) {
+            for (int column = area.firstColumn; column <= area.lastColumn; ++column)
+                unlinkFrom(columnRanges, column);
+        } else if (isShort(area)) {
+            for (int band = rowBand(area.firstRow); band <= rowBand(area.lastRow); ++band)
+                unlinkFrom(rowBandRanges, band);
+        } else {
+            wideRanges.erase(std::remove_if(wideRanges.begin(), wideRanges.end(), isLinkOf),
+                             wideRanges.end());
+        }
+    }
+}
+
+void FormulaEngine::markDependentsDirty(quint64 key)
+{
+    // A dirty formula always has dirty dependents, so the walk stops there.
+    QVector<quint64> pending;
+    pending.append(key);
+
+    auto visit = [&](quint64 formula) {
+        auto it = nodes.find(formula);
+        if (it == nodes.end() || it->dirty)
+            return;
+        it->dirty = true;
+        dirty.insert(formula);
+        pending.append(formula);
+    };
+
+    while (!pending.isEmpty()) {
+        const quint64 current = pending.takeLast();
+        const int row         = rowOf(current);
+        const int column      = columnOf(current);
+
+        auto cellIt = cellDependents.constFind(current);
+        if (cellIt != cellDependents.constEnd()) {
+            for (quint64 formula : *cellIt)
+                visit(formula);
+        }
+
+        auto rangeIt = columnRanges.constFind(column);
+        if (rangeIt != columnRanges.constEnd()) {
+            for (const RangeLink &link : *rangeIt) {
+                if (link.area.contains(row, column))
+                    visit(link.formula);
+            }
+        }
+
+        auto bandIt = rowBandRanges.constFind(rowBand(row));
+        if (bandIt != rowBandRanges.constEnd()) {
+            for (const RangeLink &link : *bandIt) {
+                if (link.area.contains(row, column))
+                    visit(link.formula);
+            }
+        }
+
+        for (const RangeLink &link : wideRanges) {
+            if (link.area.contains(row, column))
+                visit(link.formula);
+        }
+    }
+}
+
+void FormulaEngine::dirtyPrecedents(const Node &node, QVector<quint64> &out) const
+{
+    for (quint64 precedent : node.cells) {
+        auto it = nodes.constFind(precedent);
+        if (it != nodes.constEnd() && it->dirty)
+            out.append(precedent);
+    }
+
+    for (const Area &area : node.ranges) {
+        const qint64 cellCount = qint64(area.lastRow - area.firstRow + 1) *
+                                 (area.lastColumn - area.firstColumn + 1);
+        if (cellCount > dirty.size()) {
+            for (quint64 key : dirty) {
+                if (area.contains(rowOf(key), columnOf(key)))
+                    out.append(key);
+            }
+        } else {
+            forEachCell(area, [&](int row, int column, const Cell *) {
+                const quint64 key = keyOf(row, column);
+                auto it           = nodes.constFind(key);
+                if (it != nodes.constEnd() && it->dirty)
+                    out.append(key);
+            });
+        }
+    }
+}
+
+FormulaEngine::Value FormulaEngine::evaluate(const Node &node)
+{
+    stack.resize(0);
+
+    const Program &program = node.program;
+    for (const Op &op : program.ops) {
+        switch (op.code) {
+        case PushNumber:
+            stack.append(makeNumber(op.number));
+            break;
+        case PushString:
+            stack.append(makeString(program.strings.at(op.argc)));
+            break;
+        case PushBoolean:
+            stack.append(makeBoolean(op.number != 0));
+            break;
+        case PushError:
+            stack.append(makeError(program.strings.at(op.argc)));
+            break;
+        case PushReference: {
+            Value value;
+            value.type = Value::Reference;
+            value.area = op.area;
+            stack.append(value);
+            break;
+        }
+        case PushMissing: {
+            Value value;
+            value.type = Value::Missing;
+            stack.append(value);
+            break;
+        }
+        case Negate:
+        case Percent: {
+            double number = 0;
+            Value error;
+            if (!toNumber(scalar(stack.last()), &number, &error))
+                stack.last() = error;
+            else
+                stack.last() = makeNumber(op.code == Negate ? -number : number / 100);
+            break;
+        }
+        case Add:
+        case Subtract:
+        case Multiply:
+        case Divide:
+        case Power: {
+            const Value rhs = scalar(stack.takeLast());
+            const Value lhs = scalar(stack.last());
+            double a        = 0;
+            double b        = 0;
+            Value error;
+            if (!toNumber(lhs, &a, &error) || !toNumber(rhs, &b, &error)) {
+                stack.last() = error;
+                break;
+            }
+
+            double result = 0;
+            if (op.code == Add) {
+                result = a + b;
+            } else if (op.code == Subtract) {
+                result = a - b;
+            } else if (op.code == Multiply) {
+                result = a * b;
+            } else if (op.code == Divide) {
+                if (b == 0) {
+                    stack.last() = makeError(QStringLiteral("#DIV/0!"));
+                    break;
+                }
+                result = a / b;
+            } else {
+                result = (a == 0 && b == 0) ? std::numeric_limits<double>::quiet_NaN()
+                                            : std::pow(a, b);
+            }
+            stack.last() =
+                std::isfinite(result) ? makeNumber(result) : makeError(QStringLiteral("#NUM!"));
+            break;
+        }
+        case Concat: {
+            const Value rhs = scalar(stack.takeLast());
+            const Value lhs = scalar(stack.last());
+            if (lhs.type == Value::Error)
+                stack.last() = lhs;
+            else if (rhs.type == Value::Error)
+                stack.last() = rhs;
+            else
+                stack.last() = makeString(toText(lhs) + toText(rhs));
+            break;
+        }
+        case Equal:
+        case NotEqual:
+        case Less:
+        case Greater:
+        case LessEqual:
+        case GreaterEqual: {
+            const Value rhs = scalar(stack.takeLast());
+            const Value lhs = scalar(stack.last());
+            if (lhs.type == Value::Error) {
+                stack.last() = lhs;
+                break;
+            }
+            if (rhs.type == Value::Error) {
+                stack.last() = rhs;
+                break;
+            }
+            const int cmp = compareValues(lhs, rhs);
+            bool result   = false;
+            switch (op.code) {
+            case Equal:
+                result = cmp == 0;
+                break;
+            case NotEqual:
+                result = cmp != 0;
+                break;
+            case Less:
+                result = cmp < 0;
+                break;
+            case Greater:
+                result = cmp > 0;
+                break;
+            case LessEqual:
+                result = cmp <= 0;
+                break;
+            default:
+                result = cmp >= 0;
+                break;
+            }
+            stack.last() = makeBoolean(result);
+            break;
+        }
+        case Call: {
+            const int base     = stack.size() - op.argc;
+            const Value result = callFunction(op.function, stack.constData() + base, op.argc);
+            stack.resize(base);
+            stack.append(result);
+            break;
+        }
+        }
+    }
+
+    if (stack.size() != 1)
+        return valueError();
+
+    Value result = scalar(stack.last());
+    if (result.type == Value::Empty || result.type == Value::Missing)
+        return makeNumber(0);
+    return result;
+}
+
+FormulaEngine::Value FormulaEngine::valueOf(const Cell *cell) const
+{
+    const CellPrivate *d = cell->d_ptr;
+    switch (d->cellType) {
+    case Cell::BooleanType:
+        return makeBoolean(d->value.toBool());
+    case Cell::ErrorType:
+        return makeError(d->value.toString());
+    case Cell::SharedStringType:
+    case Cell::InlineStringType:
+    case Cell::StringType:
+        return makeString(d->value.toString());
+    default:
+        break;
+    }
+
+    if (!d->value.isValid())
+        return Value();
+
+    const bool is1904 = sheet->workbook && sheet->workbook->isDate1904();
+    switch (d->value.userType()) {
+    case QMetaType::QDateTime:
+        return makeNumber(datetimeToNumber(d->value.toDateTime(), is1904));
+    case QMetaType::QDate:
+        return makeNumber(datetimeToNumber(QDateTime(d->value.toDate(), QTime(0, 0)), is1904));
+    case QMetaType::QTime:
+        return makeNumber(timeToNumber(d->value.toTime()));
+    default:
+        return makeNumber(d->value.toDouble());
+    }
+}
+
+FormulaEngine::Value FormulaEngine::cellValue(int row, int column) const
+{
+    const auto &rows = sheet->cellTable.cells;
+    auto rowIt       = rows.constFind(row);
+    if (rowIt == rows.constEnd())
+        return Value();
+    auto it = rowIt->constFind(column);
+    if (it == rowIt->constEnd())
+        return Value();
+    return valueOf(it->get());
+}
+
+// References used as operands must be a single cell; no implicit intersection.
+FormulaEngine::Value FormulaEngine::scalar(const Value &value) const
+{
+    if (value.type != Value::Reference)
+        return value;
+
+    const Area &area = value.area;
+    if (area.firstRow == area.lastRow && area.firstColumn == area.lastColumn)
+        return cellValue(area.firstRow, area.firstColumn);
+    return valueError();
+}
+
+FormulaEngine::Value FormulaEngine::callFunction(quint8 function,
+                                                 const Value *args,
+                                                 int argc) const
+{
+    if (function == If) {
+        const Value condition = scalar(args[0]);
+        bool truth            = false;
+        switch (condition.type) {
+        case Value::Error:
+            return condition;
+        case Value::Number:
+        case Value::Boolean:
+            truth = condition.number != 0;
+            break;
+        case Value::String:
+            if (condition.text.compare(QLatin1String("TRUE"), Qt::CaseInsensitive) == 0)
+                truth = true;
+            else if (condition.text.compare(QLatin1String("FALSE"), Qt::CaseInsensitive) != 0)
+                return valueError();
+            break;
+        default:
+            break;
+        }
+
+        if (!truth && argc < 3)
+            return makeBoolean(false);
+        const Value &branch = args[truth ? 1 : 2];
+        return branch.type == Value::Missing ? makeNumber(0) : branch;
+    }
+
+    if (function == Count) {
+        // COUNT never fails: numbers in references, numeric-looking direct arguments.
+        int count = 0;
+        for (int i = 0; i < argc; ++i) {
+            const Value &arg = args[i];
+            if (arg.type == Value::Reference) {
+                forEachCell(arg.area, [&](int, int, const Cell *cell) {
+                    if (valueOf(cell).type == Value::Number)
+                        ++count;
+                });
+            } else if (arg.type == Value::Number || arg.type == Value::Boolean) {
+                ++count;
+            } else if (arg.type == Value::String) {
+                bool ok = false;
+                arg.text.trimmed().toDouble(&ok);
+                if (ok)
+                    ++count;
+            }
+        }
+        return makeNumber(count);
+    }
+
+    // SUM, AVERAGE, MIN and MAX: references contribute their numbers only,
+    // direct arguments are converted and the first error wins.
+    double sum = 0;
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+    int count  = 0;
+    Value error;
+    bool failed = false;
+
+    auto add = [&](double number) {
+        sum += number;
+        min = qMin(min, number);
+        max = qMax(max, number);
+        ++count;
+    };
+
+    for (int i = 0; i < argc && !failed; ++i) {
+        const Value &arg = args[i];
+        if (arg.type == Value::Reference) {
+            forEachCell(arg.area, [&](int, int, const Cell *cell) {
+                if (failed)
+                    return;
+                const Value value = valueOf(cell);
+                if (value.type == Value::Error) {
+                    error  = value;
+                    failed = true;
+                } else if (value.type == Value::Number) {
+                    add(value.number);
+                }
+            });
+        } else {
+            double number = 0;
+            if (!toNumber(arg, &number, &error))
+                failed = true;
+            else
+                add(number);
+        }
+    }
+    if (failed)
+        return error;
+
+    switch (function) {
+    case Sum:
+        return makeNumber(sum);
+    case Average:
+        return count ? makeNumber(sum / count) : makeError(QStringLiteral("#DIV/0!"));
+    case Min:
+        return makeNumber(count ? min : 0);
+    default:
+        return makeNumber(count ? max : 0);
+    }
+}
+
+void FormulaEngine::store(int row, int column, const Value &value)
+{
+    const auto cell = sheet->detachCell(row, column);
+    if (!cell)
+        return;
+
+    CellPrivate *d = cell->d_ptr;
+    switch (value.type) {
+    case Value::String:
+        d->cellType = Cell::StringType;
+        d->value    = value.text;
+        break;
+    case Value::Boolean:
+        d->cellType = Cell::BooleanType;
+        d->value    = value.number != 0;
+        break;
+    case Value::Error:
+        d->cellType = Cell::ErrorType;
+        d->value    = value.text;
+        break;
+    default:
+        d->cellType = Cell::NumberType;
+        d->value    = value.number;
+        break;
+    }
+}
+
+QT_END_NAMESPACE_XLSX
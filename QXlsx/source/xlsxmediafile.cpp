@@ -2,24 +2,35 @@
 
 #include "xlsxmediafile_p.h"
 
-#include <QCryptographicHash>
+#include <QHash>
 
 QT_BEGIN_NAMESPACE_XLSX
 
+/*
+ * Media files are deduplicated by content, so the key only has to be a
+ * fast, well distributed hash: equal keys are confirmed by comparing the
+ * bytes. A cryptographic digest over every image is not needed for that.
+ */
+static quint64 contentHash(const QByteArray &bytes)
+{
+    return quint64(qHashBits(bytes.constData(), size_t(bytes.size()), 0));
+}
+
 MediaFile::MediaFile(const QByteArray &bytes, const QString &suffix, const QString &mimeType)
     : m_contents(bytes)
     , m_suffix(suffix)
     , m_mimeType(mimeType)
     , m_index(0)
     , m_indexValid(false)
+    , m_hashKey(contentHash(bytes))
 {
-    m_hashKey = QCryptographicHash::hash(m_contents, QCryptographicHash::Md5);
 }
 
 MediaFile::MediaFile(const QString &fileName)
     : m_fileName(fileName)
     , m_index(0)
     , m_indexValid(false)
+    , m_hashKey(contentHash(QByteArray()))
 {
 }
 
@@ -28,8 +39,9 @@ void MediaFile::set(const QByteArray &bytes, const QString &suffix, const QStrin
     m_contents   = bytes;
     m_suffix     = suffix;
     m_mimeType   = mimeType;
-    m_hashKey    = QCryptographicHash::hash(m_contents, QCryptographicHash::Md5);
+    m_hashKey    = contentHash(m_contents);
     m_indexValid = false;
+    m_image      = QImage();
 }
 
 void MediaFile::setFileName(const QString &name)
@@ -73,7 +85,18 @@ void MediaFile::setIndex(int idx)
     m_indexValid = true;
 }
 
-QByteArray MediaFile::hashKey() const
+/*
+ * Returns the decoded image. The contents are only decoded the first time
+ * this is called and the result is kept until the contents change.
+ */
+QImage MediaFile::image() const
+{
+    if (m_image.isNull() && !m_contents.isEmpty())
+        m_image.loadFromData(m_contents);
+    return m_image;
+}
+
+quint64 MediaFile::hashKey() const
 {
     return m_hashKey;
 }
@@ -0,0 +1,131 @@
+// xlsxrangeindex.cpp
+
+#include "xlsxrangeindex_p.h"
+
+#include <algorithm>
+
+QT_BEGIN_NAMESPACE_XLSX
+
+namespace {
+
+const int RowBandHeight   = 32;
+const int ColumnBandWidth = 16;
+const int MaxBands        = 32; // buckets a range may be registered in
+
+int rowBand(int row)
+{
+    return (row - 1) / RowBandHeight;
+}
+
+int columnBand(int column)
+{
+    return (column - 1) / ColumnBandWidth;
+}
+
+} // namespace
+
+void RangeIndex::clear()
+{
+    entries.clear();
+    rowBands.clear();
+    columnBands.clear();
+    wideRanges.clear();
+    itemCount = 0;
+}
+
+/*
+ * Appends an item covering \a ranges. Invalid ranges are ignored, the item
+ * is numbered anyway so that items keep matching their list positions.
+ */
+void RangeIndex::append(const QList<CellRange> &ranges)
+{
+    const int item = itemCount++;
+    for (const CellRange &range : ranges) {
+        if (!range.isValid())
+            continue;
+
+        const Entry entry = {
+            range.firstRow(), range.firstColumn(), range.lastRow(), range.lastColumn(), item};
+        const int idx = entries.size();
+        entries.append(entry);
+
+        const int firstRowBand = rowBand(range.firstRow());
+        const int lastRowBand  = rowBand(range.lastRow());
+        if (lastRowBand - firstRowBand < MaxBands) {
+            for (int band = firstRowBand; band <= lastRowBand; ++band)
+                rowBands[band].append(idx);
+            continue;
+        }
+
+        const int firstColumnBand = columnBand(range.firstColumn());
+        const int lastColumnBand  = columnBand(range.lastColumn());
+        if (lastColumnBand - firstColumnBand < MaxBands) {
+            for (int band = firstColumnBand; band <= lastColumnBand; ++band)
+                columnBands[band].append(idx);
+            continue;
+        }
+
+        wideRanges.append(idx);
+    }
+}
+
+void RangeIndex::collect(const QVector<int> &bucket,
+                         const CellRange &range,
+                         QVector<int> &items) const
+{
+    for (int idx : bucket) {
+        const Entry &entry = entries.at(idx);
+        if (entry.intersects(
+                range.firstRow(), range.firstColumn(), range.lastRow(), range.lastColumn()))
+            items.append(entry.item);
+    }
+}
+
+void RangeIndex::collectBands(const QHash<int, QVector<int>> &bands,
+                              int firstBand,
+                              int lastBand,
+                              const CellRange &range,
+                              QVector<int> &items) const
+{
+    if (lastBand - firstBand < bands.size()) {
+        for (int band = firstBand; band <= lastBand; ++band) {
+            auto it = bands.constFind(band);
+            if (it != bands.constEnd())
+                collect(it.value(), range, items);
+        }
+    } else {
+        // The range spans more bands than are populated
+        for (auto it = bands.constBegin(); it != bands.constEnd(); ++it) {
+            if (it.key() >= firstBand && it.key() <= lastBand)
+                collect(it.value(), range, items);
+        }
+    }
+}
+
+QVector<int> RangeIndex::itemsAt(int row, int column) const
+{
+    return itemsIntersecting(CellRange(row, column, row, column));
+}
+
+QVector<int> RangeIndex::itemsIntersecting(const CellRange &range) const
+{
+    QVector<int> items;
+    if (!range.isValid() || entries.isEmpty())
+        return items;
+
+    collectBands(rowBands, rowBand(range.firstRow()), rowBand(range.lastRow()), range, items);
+    collectBands(columnBands,
+                 columnBand(range.firstColumn()),
+                 columnBand(range.lastColumn()),
+                 range,
+                 items);
+    collect(wideRanges, range, items);
+
+    // A range registered in several bands, or an item with several ranges,
+    // is found more than once
+    std::sort(items.begin(), items.end());
+    items.erase(std::unique(items.begin(), items.end()), items.end());
+    return items;
+}
+
+QT_END_NAMESPACE_XLSX
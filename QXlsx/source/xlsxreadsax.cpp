@@ -3,39 +3,18 @@
 #include "xlsxzipreader_p.h"    // QXlsx internal zip reader (adjust include as per project structure)
 
 #include "xlsxreadsax.h"
+#include "xlsxutility_p.h"
 
 #include <QtCore>
 #include <QXmlStreamReader>
 
 namespace QXlsx {
 
-int parse_col_letters(const QStringView& s, int* letters_len)
-{
-    // A -> 1, Z -> 26, AA -> 27 ...
-    int col = 0;
-    int len = 0;
-    for (int i = 0; i < s.size(); ++i) {
-        const QChar ch = s.at(i);
-        if (ch < QLatin1Char('A') || ch > QLatin1Char('Z'))
-            break;
-        col = col * 26 + (ch.unicode() - QLatin1Char('A').unicode() + 1);
-        ++len;
-    }
-    if (letters_len)
-        *letters_len = len;
-    return col;
-}
-
-bool parse_cell_ref(const QString& r, int* out_row, int* out_col)
+bool parse_cell_ref(QStringView r, int* out_row, int* out_col)
 {
     // Example: "C12"
-    int letters_len = 0;
-    int col = parse_col_letters(QStringView(r), &letters_len);
-    if (col <= 0 || letters_len <= 0)
-        return false;
-    bool ok = false;
-    int row = r.mid(letters_len).toInt(&ok);
-    if (!ok || row <= 0)
+    int row = 0, col = 0;
+    if (!parseCellRef(r, &row, &col) || row <= 0)
         return false;
     if (out_row) *out_row = row;
     if (out_col) *out_col = col;
@@ -86,7 +65,8 @@ bool read_sheet_xml_sax(const QByteArray& sheet_xml,
     bool in_c = false;
     bool in_v = false;
 
-    QString cell_r;
+    int cell_row = 0, cell_col = 0;
+    bool cell_ref_ok = false;
     QString cell_t;
     QString cell_s;
     QString v_text;
@@ -101,9 +81,11 @@ bool read_sheet_xml_sax(const QByteArray& sheet_xml,
                 in_sheetdata = true;
             } else if (in_sheetdata && name == QLatin1String("c")) {
                 in_c = true;
-                cell_r = rd.attributes().value(QLatin1String("r")).toString();
-                cell_t = rd.attributes().value(QLatin1String("t")).toString();
-                cell_s = rd.attributes().value(QLatin1String("s")).toString();
+                // Reference parsed straight from the attribute, no string copy
+                const QXmlStreamAttributes attrs = rd.attributes();
+                cell_ref_ok = parse_cell_ref(attrs.value(QLatin1String("r")), &cell_row, &cell_col);
+                cell_t = attrs.value(QLatin1String("t")).toString();
+                cell_s = attrs.value(QLatin1String("s")).toString();
                 v_text.clear();
             } else if (in_c && name == QLatin1String("v")) {
                 in_v = true;
@@ -130,14 +112,13 @@ bool read_sheet_xml_sax(const QByteArray& sheet_xml,
             } else if (in_c && name == QLatin1String("c")) {
                 in_c = false;
 
-                int row = 0, col = 0;
-                if (!parse_cell_ref(cell_r, &row, &col)) {
+                if (!cell_ref_ok) {
                     continue;
                 }
 
                 sax_cell c;
-                c.row = row;
-                c.col = col;
+                c.row = cell_row;
+                c.col = cell_col;
 
                 if (cell_t == QLatin1String("s")) {
                     bool ok = false;
@@ -173,4 +173,17 @@ bool Relationships::isEmpty() const
     return m_relationships.isEmpty();
 }
 
+/*
+ * Returns true if no relationship points to another part of the package,
+ * e.g. only external hyperlinks.
+ */
+bool Relationships::hasOnlyExternalTargets() const
+{
+    for (const XlsxRelationship &relation : m_relationships) {
+        if (relation.targetMode != QLatin1String("External"))
+            return false;
+    }
+    return true;
+}
+
 QT_END_NAMESPACE_XLSX
@@ -57,17 +57,30 @@ int SharedStrings::addSharedString(const RichString &string)
     int index             = m_stringList.size();
     m_stringTable[string] = XlsxSharedStringInfo(index);
     m_stringList.append(string);
+    markModified();
     return index;
 }
 
-void SharedStrings::incRefByStringIndex(int idx)
+void SharedStrings::incRefByStringIndex(int idx, int count)
 {
     if (idx < 0 || idx >= m_stringList.size()) {
         qDebug("SharedStrings: invalid index");
         return;
     }
 
-    addSharedString(m_stringList[idx]);
+    m_stringCount += count;
+    auto it = m_stringTable.find(m_stringList[idx]);
+    if (it != m_stringTable.end())
+        it->count += count;
+}
+
+/*
+ * Counts \a count more uses of strings already in the table, e.g. by the
+ * cells of a copied worksheet.
+ */
+void SharedStrings::addReferences(int count)
+{
+    m_stringCount += count;
 }
 
 /*
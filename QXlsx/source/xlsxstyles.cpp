@@ -80,6 +80,11 @@ Format Styles::xfFormat(int idx) const
     return m_xf_formatsList[idx];
 }
 
+int Styles::xfFormatCount() const
+{
+    return m_xf_formatsList.size();
+}
+
 Format Styles::dxfFormat(int idx) const
 {
     if (idx < 0 || idx >= m_dxf_formatsList.size())
@@ -165,6 +170,7 @@ void Styles::fixNumFmt(const Format &format)
                 fmt->formatString = str;
                 m_customNumFmtIdMap.insert(m_nextCustomNumFmtId, fmt);
                 m_customNumFmtsHash.insert(str, fmt);
+                markModified();
 
                 m_nextCustomNumFmtId += 1;
             }
@@ -230,6 +236,7 @@ void Styles::addXfFormat(const Format &format, bool force)
         // Still a valid font if the format has no fontData. (All font properties are default)
         m_fontsList.append(format);
         m_fontsHash[format.fontKey()] = format;
+        markModified();
     }
 
     // Fill
@@ -245,6 +252,7 @@ void Styles::addXfFormat(const Format &format, bool force)
         // Still a valid fill if the format has no fillData. (All fill properties are default)
         m_fillsList.append(format);
         m_fillsHash[format.fillKey()] = format;
+        markModified();
     }
 
     // Border
@@ -260,6 +268,7 @@ void Styles::addXfFormat(const Format &format, bool force)
         // Still a valid border if the format has no borderData. (All border properties are default)
         m_bordersList.append(format);
         m_bordersHash[format.borderKey()] = format;
+        markModified();
     }
 
     // Format
@@ -274,6 +283,7 @@ void Styles::addXfFormat(const Format &format, bool force)
     if (formatIt == m_xf_formatsHash.constEnd() || force) {
         m_xf_formatsList.append(format);
         m_xf_formatsHash[format.formatKey()] = format;
+        markModified();
     }
 }
 
@@ -297,6 +307,7 @@ void Styles::addDxfFormat(const Format &format, bool force)
     if (formatIt == m_dxf_formatsHash.constEnd() || force) {
         m_dxf_formatsList.append(format);
         m_dxf_formatsHash[format.formatKey()] = format;
+        markModified();
     }
 }
 
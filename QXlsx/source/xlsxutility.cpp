@@ -216,85 +216,284 @@ QString convertSharedFormula(const QString &rootFormula,
                              const CellReference &rootCell,
                              const CellReference &cell)
 {
-    Q_UNUSED(rootCell)
-    Q_UNUSED(cell)
-    // Find all the "$?[A-Z]+$?[0-9]+" patterns in the rootFormula.
-    QVector<std::pair<QString, int>> segments;
+    return SharedFormulaTemplate(rootFormula, rootCell).instantiate(cell);
+}
+
+namespace {
+
+// Last column written with 1, 2 and 3 letters: Z, ZZ and ZZZ.
+constexpr int kColumnLetterLimits[] = {26, 26 + 26 * 26, 26 + 26 * 26 + 26 * 26 * 26};
+
+constexpr char kColumnLetters[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+// A reference can not go past XFD1048576. Parsing stops accumulating
+// past these many letters and digits, so no input can overflow an int.
+constexpr int kMaxColumnLetters = 3;
+constexpr int kMaxRowDigits     = 9;
+constexpr int kLastRow          = 1048576;
+constexpr int kLastColumn       = 16384;
+
+constexpr int columnLetterCount(int column)
+{
+    return column <= kColumnLetterLimits[0]   ? 1
+           : column <= kColumnLetterLimits[1] ? 2
+           : column <= kColumnLetterLimits[2] ? 3
+                                              : 1 + columnLetterCount((column - 1) / 26);
+}
+
+static_assert(columnLetterCount(16384) == 3, "XFD is the last column of a worksheet");
+
+inline ushort codeOf(QChar ch)
+{
+    return ch.unicode();
+}
+
+inline ushort codeOf(char ch)
+{
+    return uchar(ch);
+}
+
+inline void put(QChar *out, char ch)
+{
+    *out = QLatin1Char(ch);
+}
+
+inline void put(char *out, char ch)
+{
+    *out = ch;
+}
+
+template <typename Char>
+int parseColumnLettersImpl(const Char *data, int size, int *length)
+{
+    // A -> 1, Z -> 26, AA -> 27 ...
+    int column = 0;
+    int i      = 0;
+    while (i < size) {
+        const ushort ch = codeOf(data[i]);
+        if (ch < 'A' || ch > 'Z')
+            break;
+        // Longer runs are still measured, callers reject them by length
+        if (i < kMaxColumnLetters)
+            column = column * 26 + (ch - 'A' + 1);
+        ++i;
+    }
+    if (length)
+        *length = i;
+    return column;
+}
+
+template <typename Char>
+bool parseCellRefImpl(const Char *data, int size, int *row, int *column, int *flags)
+{
+    int i = 0;
+    int f = 0;
+    if (i < size && codeOf(data[i]) == '$') {
+        f |= 0x01;
+        ++i;
+    }
+    int letters   = 0;
+    const int col = parseColumnLettersImpl(data + i, size - i, &letters);
+    if (letters == 0 || letters > kMaxColumnLetters || col > kLastColumn)
+        return false;
+    i += letters;
+    if (i < size && codeOf(data[i]) == '$') {
+        f |= 0x02;
+        ++i;
+    }
+    int r      = 0;
+    int digits = 0;
+    while (i < size) {
+        const ushort ch = codeOf(data[i]);
+        if (ch < '0' || ch > '9')
+            break;
+        if (digits < kMaxRowDigits)
+            r = r * 10 + (ch - '0');
+        ++digits;
+        ++i;
+    }
+    if (digits == 0 || digits > kMaxRowDigits || i != size || r < 1 || r > kLastRow)
+        return false;
+
+    *row    = r;
+    *column = col;
+    if (flags)
+        *flags = f;
+    return true;
+}
+
+template <typename Char>
+int writeColumnLettersImpl(Char *buffer, int column)
+{
+    // The letter count is known up front, so the letters go straight to their place.
+    const int count = columnLetterCount(column);
+    for (int i = count - 1; i >= 0; --i) {
+        put(buffer + i, kColumnLetters[(column - 1) % 26]);
+        column = (column - 1) / 26;
+    }
+    return count;
+}
 
-    QString segment;
+template <typename Char>
+int writeCellRefImpl(Char *buffer, int row, int column, int flags)
+{
+    if (row <= 0 || column <= 0)
+        return 0;
+
+    int pos = 0;
+    if (flags & 0x01)
+        put(buffer + pos++, '$');
+    pos += writeColumnLettersImpl(buffer + pos, column);
+    if (flags & 0x02)
+        put(buffer + pos++, '$');
+
+    int digits = 1;
+    for (int value = row; value >= 10; value /= 10)
+        ++digits;
+    for (int i = digits - 1; i >= 0; --i) {
+        put(buffer + pos + i, char('0' + row % 10));
+        row /= 10;
+    }
+    return pos + digits;
+}
+
+} // namespace
+
+int parseColumnLetters(QStringView text, int *length)
+{
+    return parseColumnLettersImpl(text.data(), int(text.size()), length);
+}
+
+bool parseCellRef(QStringView text, int *row, int *column, int *flags)
+{
+    return parseCellRefImpl(text.data(), int(text.size()), row, column, flags);
+}
+
+bool parseCellRef(const char *text, int size, int *row, int *column, int *flags)
+{
+    return parseCellRefImpl(text, size, row, column, flags);
+}
+
+int writeColumnLetters(QChar *buffer, int column)
+{
+    return column > 0 ? writeColumnLettersImpl(buffer, column) : 0;
+}
+
+int writeCellRef(QChar *buffer, int row, int column, int flags)
+{
+    return writeCellRefImpl(buffer, row, column, flags);
+}
+
+int writeCellRef(char *buffer, int row, int column, int flags)
+{
+    return writeCellRefImpl(buffer, row, column, flags);
+}
+
+SharedFormulaTemplate::SharedFormulaTemplate(const QString &rootFormula,
+                                             const CellReference &rootCell)
+    : formula(rootFormula)
+    , rootRow(rootCell.row())
+    , rootColumn(rootCell.column())
+{
+    // Find all the "$?[A-Z]+$?[0-9]+" patterns in the rootFormula. Segments are
+    // kept as [start, i) offsets into the formula instead of being copied out.
+    const QChar *data = formula.constData();
+    const int size    = formula.size();
+
+    int start    = 0;
     bool inQuote = false;
     enum RefState { INVALID, PRE_AZ, AZ, PRE_09, _09 };
     RefState refState = INVALID;
     int refFlag       = 0; // 0x00, 0x01, 0x02, 0x03 ==> A1, $A1, A$1, $A$1
-    for (QChar ch : rootFormula) {
+
+    auto finishSegment = [&](int end, int flag) {
+        int length = end - start;
+        if (length <= 0)
+            return;
+        int row    = 0;
+        int column = 0;
+        // "$A$1" does not move, keep it as literal text.
+        if (flag != -1 && flag != 3 &&
+            parseCellRef(QStringView(data + start, length), &row, &column))
+            tokens.append(Token{-1, 0, row, column, flag});
+        else
+            appendLiteral(start, length);
+    };
+
+    for (int i = 0; i < size; ++i) {
+        const QChar ch = data[i];
         if (inQuote) {
-            segment.append(ch);
             if (ch == QLatin1Char('"'))
                 inQuote = false;
         } else {
             if (ch == QLatin1Char('"')) {
                 inQuote  = true;
                 refState = INVALID;
-                segment.append(ch);
             } else if (ch == QLatin1Char('$')) {
                 if (refState == AZ) {
-                    segment.append(ch);
                     refState = PRE_09;
                     refFlag |= 0x02;
                 } else {
-                    segments.append(std::make_pair(segment, refState == _09 ? refFlag : -1));
-                    segment  = QString(ch); // Start new segment.
+                    finishSegment(i, refState == _09 ? refFlag : -1);
+                    start    = i; // Start new segment.
                     refState = PRE_AZ;
                     refFlag  = 0x01;
                 }
             } else if (ch >= QLatin1Char('A') && ch <= QLatin1Char('Z')) {
-                if (refState == PRE_AZ || refState == AZ) {
-                    segment.append(ch);
-                } else {
-                    segments.append(std::make_pair(segment, refState == _09 ? refFlag : -1));
-                    segment = QString(ch); // Start new segment.
+                if (refState != PRE_AZ && refState != AZ) {
+                    finishSegment(i, refState == _09 ? refFlag : -1);
+                    start   = i; // Start new segment.
                     refFlag = 0x00;
                 }
                 refState = AZ;
             } else if (ch >= QLatin1Char('0') && ch <= QLatin1Char('9')) {
-                segment.append(ch);
-
                 if (refState == AZ || refState == PRE_09 || refState == _09)
                     refState = _09;
                 else
                     refState = INVALID;
             } else {
                 if (refState == _09) {
-                    segments.append(std::make_pair(segment, refFlag));
-                    segment = QString(ch); // Start new segment.
-                } else {
-                    segment.append(ch);
+                    finishSegment(i, refFlag);
+                    start = i; // Start new segment.
                 }
                 refState = INVALID;
             }
         }
     }
+    finishSegment(size, refState == _09 ? refFlag : -1);
+}
 
-    if (!segment.isEmpty())
-        segments.append(std::make_pair(segment, refState == _09 ? refFlag : -1));
-
-    // Replace "A1", "$A1", "A$1" segment with proper one.
-    QStringList result;
-    for (const auto &p : segments) {
-        // qDebug()<<p.first<<p.second;
-        if (p.second != -1 && p.second != 3) {
-            CellReference oldRef(p.first);
-            int row = p.second & 0x02 ? oldRef.row() : oldRef.row() - rootCell.row() + cell.row();
-            int col = p.second & 0x01 ? oldRef.column()
-                                      : oldRef.column() - rootCell.column() + cell.column();
-            result.append(CellReference(row, col).toString(p.second & 0x02, p.second & 0x01));
-        } else {
-            result.append(p.first);
+void SharedFormulaTemplate::appendLiteral(int begin, int length)
+{
+    // Merge with the previous literal run when they are adjacent.
+    if (!tokens.isEmpty()) {
+        Token &last = tokens.last();
+        if (last.begin >= 0 && last.begin + last.length == begin) {
+            last.length += length;
+            return;
         }
     }
+    tokens.append(Token{begin, length, 0, 0, 0});
+}
 
-    // OK
-    return result.join(QString());
+QString SharedFormulaTemplate::instantiate(const CellReference &cell) const
+{
+    const int rowOffset    = cell.row() - rootRow;
+    const int columnOffset = cell.column() - rootColumn;
+
+    QString result;
+    result.reserve(formula.size() + 8);
+    for (const Token &token : tokens) {
+        if (token.begin >= 0) {
+            result.append(formula.constData() + token.begin, token.length);
+        } else {
+            int row    = token.flags & 0x02 ? token.row : token.row + rowOffset;
+            int column = token.flags & 0x01 ? token.column : token.column + columnOffset;
+            QChar buffer[CellRefBufferSize];
+            result.append(buffer, writeCellRef(buffer, row, column, token.flags));
+        }
+    }
+    return result;
 }
 
 QString xsdBoolean(bool value)
@@ -2,6 +2,7 @@
 
 #include "xlsxworkbook.h"
 
+#include "xlsxabstractsheet_p.h"
 #include "xlsxchart.h"
 #include "xlsxchartsheet.h"
 #include "xlsxformat.h"
@@ -268,7 +269,9 @@ AbstractSheet *Workbook::activeSheet() const
     Q_D(const Workbook);
     if (d->sheets.isEmpty())
         const_cast<Workbook *>(this)->addSheet();
-    return d->sheets[d->activesheetIndex].get();
+    AbstractSheet *sheet = d->sheets[d->activesheetIndex].get();
+    sheet->d_func()->loadDeferred();
+    return sheet;
 }
 
 bool Workbook::setActiveSheet(int index)
@@ -363,6 +366,7 @@ bool Workbook::copySheet(int index, const QString &newName)
     }
 
     ++d->last_sheet_id;
+    d->sheets[index]->d_func()->loadDeferred();
     AbstractSheet *sheet = d->sheets[index]->copy(worksheetName, d->last_sheet_id);
     d->sheets.append(std::shared_ptr<AbstractSheet>(sheet));
     d->sheetNames.append(sheet->sheetName());
@@ -387,7 +391,9 @@ AbstractSheet *Workbook::sheet(int index) const
     Q_D(const Workbook);
     if (index < 0 || index >= d->sheets.size())
         return nullptr;
-    return d->sheets.at(index).get();
+    AbstractSheet *sheet = d->sheets.at(index).get();
+    sheet->d_func()->loadDeferred();
+    return sheet;
 }
 
 SharedStrings *Workbook::sharedStrings() const
@@ -699,22 +705,55 @@ QList<std::shared_ptr<MediaFile>> Workbook::mediaFiles() const
 
 /*!
  * \internal
+ * Returns the media file loaded from the package path \a fileName, or
+ * nullptr if there is none.
  */
-void Workbook::addMediaFile(std::shared_ptr<MediaFile> media, bool force)
+std::shared_ptr<MediaFile> Workbook::mediaFile(const QString &fileName) const
+{
+    Q_D(const Workbook);
+
+    const int idx = d->mediaFileNames.value(fileName, -1);
+    return idx == -1 ? std::shared_ptr<MediaFile>() : d->mediaFiles[idx];
+}
+
+/*!
+ * \internal
+ * Adds \a media to the workbook and returns the media file to refer to.
+ * Unless \a force is true, a file with the same contents already in the
+ * workbook is returned instead, so identical images are stored once.
+ */
+std::shared_ptr<MediaFile> Workbook::addMediaFile(std::shared_ptr<MediaFile> media, bool force)
 {
     Q_D(Workbook);
 
+    if (!d->mediaFileHashesValid) {
+        // Loaded files get their contents after they are added
+        d->mediaFileHashes.clear();
+        for (int i = 0; i < d->mediaFiles.size(); ++i)
+            d->mediaFileHashes.insert(d->mediaFiles[i]->hashKey(), i);
+        d->mediaFileHashesValid = true;
+    }
+
     if (!force) {
-        for (int i = 0; i < d->mediaFiles.size(); ++i) {
-            if (d->mediaFiles[i]->hashKey() == media->hashKey()) {
-                media->setIndex(i);
-                return;
-            }
+        const QList<int> candidates = d->mediaFileHashes.values(media->hashKey());
+        for (int idx : candidates) {
+            const auto &existing = d->mediaFiles[idx];
+            // A file changed after it was indexed no longer matches its key
+            if (existing->hashKey() == media->hashKey() &&
+                existing->contents() == media->contents())
+                return existing;
         }
     }
 
     media->setIndex(d->mediaFiles.size());
     d->mediaFiles.append(media);
+    if (!media->fileName().isEmpty())
+        d->mediaFileNames.insert(media->fileName(), media->index());
+    if (media->contents().isEmpty())
+        d->mediaFileHashesValid = false;
+    else
+        d->mediaFileHashes.insert(media->hashKey(), media->index());
+    return media;
 }
 
 /*!
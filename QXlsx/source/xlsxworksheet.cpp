@@ -15,6 +15,7 @@
 #include "xlsxdrawinganchor_p.h"
 #include "xlsxformat.h"
 #include "xlsxformat_p.h"
+#include "xlsxformulaengine_p.h"
 #include "xlsxrichstring.h"
 #include "xlsxsharedstrings_p.h"
 #include "xlsxstyles_p.h"
@@ -30,6 +31,7 @@
 #include <QDebug>
 #include <QDir>
 #include <QFile>
+#include <QImageReader>
 #include <QMap>
 #include <QMapIterator>
 #include <QPoint>
@@ -83,50 +85,59 @@ WorksheetPrivate::~WorksheetPrivate()
 void WorksheetPrivate::calculateSpans() const
 {
     row_spans.clear();
-    int span_min = XLSX_COLUMN_MAX + 1;
-    int span_max = -1;
-
-    for (int row_num = dimension.firstRow(); row_num <= dimension.lastRow(); row_num++) {
-        for (int col_num = dimension.firstColumn(); col_num <= dimension.lastColumn(); col_num++) {
-            if (cellTable.contains(row_num, col_num)) {
-                if (span_max == -1) {
-                    span_min = col_num;
-                    span_max = col_num;
-                } else {
-                    if (col_num < span_min)
-                        span_min = col_num;
-                    else if (col_num > span_max)
-                        span_max = col_num;
-                }
-            }
-        }
+    if (!dimension.isValid())
+        return;
 
-        auto cIt = comments.constFind(row_num);
-        if (cIt != comments.constEnd()) {
-            for (int col_num = dimension.firstColumn(); col_num <= dimension.lastColumn();
-                 col_num++) {
-                if (cIt->contains(col_num)) {
-                    if (span_max == -1) {
-                        span_min = col_num;
-                        span_max = col_num;
-                    } else {
-                        if (col_num < span_min)
-                            span_min = col_num;
-                        else if (col_num > span_max)
-                            span_max = col_num;
-                    }
-                }
-            }
+    // Merge the populated column span of each row into its block of 16 rows.
+    QHash<int, CellTable::ColumnSpan> blocks;
+    auto merge = [&](int row, int first, int last) {
+        first = qMax(first, dimension.firstColumn());
+        last  = qMin(last, dimension.lastColumn());
+        if (row < dimension.firstRow() || row > dimension.lastRow() || first > last)
+            return;
+
+        const int block = (row - 1) / 16;
+        auto it         = blocks.find(block);
+        if (it == blocks.end()) {
+            blocks.insert(block, CellTable::ColumnSpan{first, last});
+        } else {
+            it->first = qMin(it->first, first);
+            it->last  = qMax(it->last, last);
         }
+    };
 
-        if (row_num % 16 == 0 || row_num == dimension.lastRow()) {
-            if (span_max != -1) {
-                row_spans[row_num / 16] = QStringLiteral("%1:%2").arg(span_min).arg(span_max);
-                span_min                = XLSX_COLUMN_MAX + 1;
-                span_max                = -1;
-            }
-        }
+    for (auto it = cellTable.rowSpans.constBegin(); it != cellTable.rowSpans.constEnd(); ++it)
+        merge(it.key(), it->first, it->last);
+    for (auto it = comments.constBegin(); it != comments.constEnd(); ++it) {
+        for (auto cIt = it->constBegin(); cIt != it->constEnd(); ++cIt)
+            merge(it.key(), cIt.key(), cIt.key());
     }
+
+    for (auto it = blocks.constBegin(); it != blocks.constEnd(); ++it)
+        row_spans[it.key()] = QStringLiteral("%1:%2").arg(it->first).arg(it->last);
+}
+
+/*
+  Rows inside the dimension that carry cells, row formatting or comments,
+  in ascending order.
+ */
+QList<int> WorksheetPrivate::populatedRows() const
+{
+    QList<int> rows;
+    rows.reserve(cellTable.cells.size() + rowsInfo.size() + comments.size());
+    for (auto it = cellTable.cells.constBegin(); it != cellTable.cells.constEnd(); ++it)
+        rows.append(it.key());
+    for (auto it = rowsInfo.constBegin(); it != rowsInfo.constEnd(); ++it)
+        rows.append(it.key());
+    for (auto it = comments.constBegin(); it != comments.constEnd(); ++it)
+        rows.append(it.key());
+
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+    auto first = std::lower_bound(rows.begin(), rows.end(), dimension.firstRow());
+    auto last  = std::upper_bound(first, rows.end(), dimension.lastRow());
+    return QList<int>(first, last);
 }
 
 QString WorksheetPrivate::generateDimensionString() const
@@ -184,6 +195,15 @@ Worksheet::Worksheet(const QString &name, int id, Workbook *workbook, CreateFlag
         d_func()->workbook = new Workbook(flag);
 }
 
+/*!
+ * \internal
+ */
+WorksheetPrivate *Worksheet::d_func()
+{
+    markModified();
+    return reinterpret_cast<WorksheetPrivate *>(d_ptr);
+}
+
 /*!
  * \internal
  *
@@ -196,39 +216,71 @@ Worksheet *Worksheet::copy(const QString &distName, int distId) const
     auto sheet                = new Worksheet(distName, distId, d->workbook, F_NewFromScratch);
     WorksheetPrivate *sheet_d = sheet->d_func();
 
-    sheet_d->dimension = d->dimension;
-
-    for (auto it = d->cellTable.cells.begin(); it != d->cellTable.cells.end(); ++it) {
-        int row = it.key();
-        for (auto it2 = it.value().begin(); it2 != it.value().end(); ++it2) {
-            int col = it2.key();
-
-            auto cell           = std::make_shared<Cell>(it2.value().get());
-            cell->d_ptr->parent = sheet;
-
-            if (cell->cellType() == Cell::SharedStringType)
-                d->workbook->sharedStrings()->addSharedString(cell->d_ptr->richString);
-
-            sheet_d->cellTable.setValue(row, col, cell);
-        }
+    // The cached formula values are shared along with the cells
+    d->recalculateFormulas();
+
+    // Both sheets share the cell table and the cells themselves until one
+    // of them modifies a cell, see WorksheetPrivate::detachCell().
+    sheet_d->cellTable   = d->cellTable;
+    d->cellsShared       = true;
+    sheet_d->cellsShared = true;
+    d->workbook->sharedStrings()->addReferences(d->cellTable.sharedStringCount);
+
+    sheet_d->dimension              = d->dimension;
+    sheet_d->merges                 = d->merges;
+    sheet_d->comments               = d->comments;
+    sheet_d->urlTable               = d->urlTable;
+    sheet_d->sharedFormulaMap       = d->sharedFormulaMap;
+    sheet_d->sharedFormulaTemplates = d->sharedFormulaTemplates;
+    sheet_d->dataValidationsList    = d->dataValidationsList;
+    sheet_d->conditionalFormattingList = d->conditionalFormattingList;
+    sheet_d->row_sizes              = d->row_sizes;
+    sheet_d->col_sizes              = d->col_sizes;
+    sheet_d->sheetFormatProps       = d->sheetFormatProps;
+
+    // Row and column infos are modified in place, give the copy its own.
+    for (auto it = d->rowsInfo.constBegin(); it != d->rowsInfo.constEnd(); ++it)
+        sheet_d->rowsInfo.insert(it.key(), std::make_shared<XlsxRowInfo>(*it.value()));
+
+    QHash<const XlsxColumnInfo *, std::shared_ptr<XlsxColumnInfo>> columnInfos;
+    for (auto it = d->colsInfo.constBegin(); it != d->colsInfo.constEnd(); ++it) {
+        auto info = std::make_shared<XlsxColumnInfo>(*it.value());
+        columnInfos.insert(it.value().get(), info);
+        sheet_d->colsInfo.insert(it.key(), info);
+    }
+    for (auto it = d->colsInfoHelper.constBegin(); it != d->colsInfoHelper.constEnd(); ++it) {
+        auto info = columnInfos.value(it.value().get());
+        sheet_d->colsInfoHelper.insert(it.key(),
+                                       info ? info : std::make_shared<XlsxColumnInfo>(*it.value()));
     }
 
-    // for (auto it = d->cellTable.cells.begin(); it != d->cellTable.cells.end(); ++it) {
-    //     auto cell           = std::make_shared<Cell>(it.value().get());
-    //     cell->d_ptr->parent = sheet;
-
-    //     if (cell->cellType() == Cell::SharedStringType)
-    //         d->workbook->sharedStrings()->addSharedString(cell->d_ptr->richString);
-
-    //     sheet_d->cellTable.setValue(CellTable::row(it.key()), CellTable::column(it.key()), cell);
-    // }
-
-    sheet_d->merges = d->merges;
-    //    sheet_d->rowsInfo = d->rowsInfo;
-    //    sheet_d->colsInfo = d->colsInfo;
-    //    sheet_d->colsInfoHelper = d->colsInfoHelper;
-    //    sheet_d->dataValidationsList = d->dataValidationsList;
-    //    sheet_d->conditionalFormattingList = d->conditionalFormattingList;
+    sheet_d->PpaperSize           = d->PpaperSize;
+    sheet_d->Pscale               = d->Pscale;
+    sheet_d->PfirstPageNumber     = d->PfirstPageNumber;
+    sheet_d->Porientation         = d->Porientation;
+    sheet_d->PuseFirstPageNumber  = d->PuseFirstPageNumber;
+    sheet_d->PhorizontalDpi       = d->PhorizontalDpi;
+    sheet_d->PverticalDpi         = d->PverticalDpi;
+    sheet_d->Pcopies              = d->Pcopies;
+    sheet_d->PMheader             = d->PMheader;
+    sheet_d->PMfooter             = d->PMfooter;
+    sheet_d->PMtop                = d->PMtop;
+    sheet_d->PMbotton             = d->PMbotton;
+    sheet_d->PMleft               = d->PMleft;
+    sheet_d->PMright              = d->PMright;
+    sheet_d->MoodFooter           = d->MoodFooter;
+    sheet_d->ModdHeader           = d->ModdHeader;
+    sheet_d->MoodalignWithMargins = d->MoodalignWithMargins;
+
+    sheet_d->windowProtection   = d->windowProtection;
+    sheet_d->showFormulas       = d->showFormulas;
+    sheet_d->showGridLines      = d->showGridLines;
+    sheet_d->showRowColHeaders  = d->showRowColHeaders;
+    sheet_d->showZeros          = d->showZeros;
+    sheet_d->rightToLeft        = d->rightToLeft;
+    sheet_d->showRuler          = d->showRuler;
+    sheet_d->showOutlineSymbols = d->showOutlineSymbols;
+    sheet_d->showWhiteSpace     = d->showWhiteSpace;
 
     return sheet;
 }
@@ -423,6 +475,8 @@ void Worksheet::setWhiteSpaceVisible(bool visible)
 /*!
  * Write \a value to cell (\a row, \a column) with the \a format.
  * Both \a row and \a column are all 1-indexed value.
+ * A value for a merged cell other than the top-left one of its range is
+ * refused, as it would never be shown.
  *
  * Returns true on success.
  */
@@ -527,21 +581,9 @@ QVariant Worksheet::read(int row, int column) const
         return QVariant();
 
     if (cell->hasFormula()) {
-        if (cell->formula().formulaType() == CellFormula::NormalType) {
-            return QVariant(QLatin1String("=") + cell->formula().formulaText());
-        } else if (cell->formula().formulaType() == CellFormula::SharedType) {
-            if (!cell->formula().formulaText().isEmpty()) {
-                return QVariant(QLatin1String("=") + cell->formula().formulaText());
-            } else {
-                int si                         = cell->formula().sharedIndex();
-                const CellFormula &rootFormula = d->sharedFormulaMap[si];
-                CellReference rootCellRef      = rootFormula.reference().topLeft();
-                QString rootFormulaText        = rootFormula.formulaText();
-                QString newFormulaText =
-                    convertSharedFormula(rootFormulaText, rootCellRef, CellReference(row, column));
-                return QVariant(QLatin1String("=") + newFormulaText);
-            }
-        }
+        const CellFormula::FormulaType type = cell->formula().formulaType();
+        if (type == CellFormula::NormalType || type == CellFormula::SharedType)
+            return QVariant(QLatin1String("=") + d->formulaText(cell->formula(), row, column));
     }
 
     if (cell->isDateTime()) {
@@ -571,9 +613,73 @@ std::shared_ptr<Cell> Worksheet::cellAt(const CellReference &row_column) const
 std::shared_ptr<Cell> Worksheet::cellAt(int row, int col) const
 {
     Q_D(const Worksheet);
+    // Bring the cached formula results up to date before handing out a cell.
+    if (d->formulaEngine && d->formulaEngine->isDirty())
+        d->formulaEngine->recalculate();
     return d->cellTable.cellAt(row, col);
 }
 
+/*
+ * Returns the text of \a formula at (\a row, \a column); the dependent cells
+ * of a shared formula get the root formula with its references offset.
+ * Array and data table formulas have no per-cell text and return an empty string.
+ */
+QString WorksheetPrivate::formulaText(const CellFormula &formula, int row, int column) const
+{
+    if (formula.formulaType() != CellFormula::NormalType &&
+        formula.formulaType() != CellFormula::SharedType)
+        return QString();
+    if (formula.formulaType() == CellFormula::NormalType || !formula.formulaText().isEmpty())
+        return formula.formulaText();
+
+    int si  = formula.sharedIndex();
+    auto it = sharedFormulaTemplates.constFind(si);
+    if (it == sharedFormulaTemplates.constEnd()) {
+        const CellFormula rootFormula = sharedFormulaMap.value(si);
+        it                            = sharedFormulaTemplates.insert(
+            si, SharedFormulaTemplate(rootFormula.formulaText(), rootFormula.reference().topLeft()));
+    }
+    return it->instantiate(CellReference(row, column));
+}
+
+/*
+ * Tells the formula engine that the cell (row, column) was written, so that
+ * the formulas depending on it get recalculated.
+ */
+void WorksheetPrivate::cellWritten(int row, int column)
+{
+    if (!formulaEngine)
+        formulaEngine.reset(new FormulaEngine(this));
+    formulaEngine->cellChanged(row, column);
+}
+
+void WorksheetPrivate::recalculateFormulas() const
+{
+    if (!formulaEngine)
+        formulaEngine.reset(new FormulaEngine(const_cast<WorksheetPrivate *>(this)));
+    formulaEngine->recalculate();
+}
+
+/*
+ * Returns the cell (row, column) for modification in place. A cell still
+ * shared with a copy of this sheet is cloned first, so the other sheets
+ * keep their version.
+ */
+std::shared_ptr<Cell> WorksheetPrivate::detachCell(int row, int column)
+{
+    auto rowIt = cellTable.cells.find(row);
+    if (rowIt == cellTable.cells.end())
+        return nullptr;
+    auto it = rowIt->find(column);
+    if (it == rowIt->end())
+        return nullptr;
+
+    std::shared_ptr<Cell> &cell = *it;
+    if (cellsShared && cell.use_count() > 1)
+        cell = std::make_shared<Cell>(cell.get());
+    return cell;
+}
+
 Format WorksheetPrivate::cellFormat(int row, int col) const
 {
     auto cell = cellTable.cellAt(row, col);
@@ -608,7 +714,7 @@ bool Worksheet::writeString(int row, int column, const RichString &value, const
 {
     Q_D(Worksheet);
     //    QString content = value.toPlainString();
-    if (d->checkDimensions(row, column))
+    if (d->checkDimensions(row, column) || d->isHiddenByMerge(row, column))
         return false;
 
     //    if (content.size() > d->xls_strmax) {
@@ -624,6 +730,7 @@ bool Worksheet::writeString(int row, int column, const RichString &value, const
     auto cell = std::make_shared<Cell>(value.toPlainString(), Cell::SharedStringType, fmt, this);
     cell->d_ptr->richString = value;
     d->cellTable.setValue(row, column, cell);
+    d->cellWritten(row, column);
     return true;
 }
 
@@ -650,7 +757,7 @@ bool Worksheet::writeString(const CellReference &row_column,
 bool Worksheet::writeString(int row, int column, const QString &value, const Format &format)
 {
     Q_D(Worksheet);
-    if (d->checkDimensions(row, column))
+    if (d->checkDimensions(row, column) || d->isHiddenByMerge(row, column))
         return false;
 
     RichString rs;
@@ -685,7 +792,7 @@ bool Worksheet::writeInlineString(int row, int column, const QString &value, con
     Q_D(Worksheet);
     // int error = 0;
     QString content = value;
-    if (d->checkDimensions(row, column))
+    if (d->checkDimensions(row, column) || d->isHiddenByMerge(row, column))
         return false;
 
     if (value.size() > XLSX_STRING_MAX) {
@@ -697,6 +804,7 @@ bool Worksheet::writeInlineString(int row, int column, const QString &value, con
     d->workbook->styles()->addXfFormat(fmt);
     auto cell = std::make_shared<Cell>(content, Cell::InlineStringType, fmt, this);
     d->cellTable.setValue(row, column, cell);
+    d->cellWritten(row, column);
 
     return true;
 }
@@ -721,13 +829,14 @@ bool Worksheet::writeNumeric(const CellReference &row_column, double value, cons
 bool Worksheet::writeNumeric(int row, int column, double value, const Format &format)
 {
     Q_D(Worksheet);
-    if (d->checkDimensions(row, column))
+    if (d->checkDimensions(row, column) || d->isHiddenByMerge(row, column))
         return false;
 
     Format fmt = format.isValid() ? format : d->cellFormat(row, column);
     d->workbook->styles()->addXfFormat(fmt);
     auto cell = std::make_shared<Cell>(value, Cell::NumberType, fmt, this);
     d->cellTable.setValue(row, column, cell);
+    d->cellWritten(row, column);
 
     return true;
 }
@@ -760,7 +869,7 @@ bool Worksheet::writeFormula(int row,
 {
     Q_D(Worksheet);
 
-    if (d->checkDimensions(row, column))
+    if (d->checkDimensions(row, column) || d->isHiddenByMerge(row, column))
         return false;
 
     Format fmt = format.isValid() ? format : d->cellFormat(row, column);
@@ -776,11 +885,13 @@ bool Worksheet::writeFormula(int row,
         }
         formula.d->si           = si;
         d->sharedFormulaMap[si] = formula;
+        d->sharedFormulaTemplates.remove(si);
     }
 
     auto data            = std::make_shared<Cell>(result, Cell::NumberType, fmt, this);
     data->d_ptr->formula = formula;
     d->cellTable.setValue(row, column, data);
+    d->cellWritten(row, column);
 
     CellRange range = formula.reference();
     if (formula.formulaType() == CellFormula::SharedType) {
@@ -789,13 +900,14 @@ bool Worksheet::writeFormula(int row,
         for (int r = range.firstRow(); r <= range.lastRow(); ++r) {
             for (int c = range.firstColumn(); c <= range.lastColumn(); ++c) {
                 if (!(r == row && c == column)) {
-                    if (auto cell = cellAt(r, c)) {
+                    if (auto cell = d->detachCell(r, c)) {
                         cell->d_ptr->formula = sf;
                     } else {
                         auto newCell = std::make_shared<Cell>(result, Cell::NumberType, fmt, this);
                         newCell->d_ptr->formula = sf;
                         d->cellTable.setValue(r, c, newCell);
                     }
+                    d->cellWritten(r, c);
                 }
             }
         }
@@ -833,6 +945,7 @@ bool Worksheet::writeBlank(int row, int column, const Format &format)
     // Note: NumberType with an invalid QVariant value means blank.
     auto cell = std::make_shared<Cell>(QVariant{}, Cell::NumberType, fmt, this);
     d->cellTable.setValue(row, column, cell);
+    d->cellWritten(row, column);
 
     return true;
 }
@@ -856,13 +969,14 @@ bool Worksheet::writeBool(const CellReference &row_column, bool value, const For
 bool Worksheet::writeBool(int row, int column, bool value, const Format &format)
 {
     Q_D(Worksheet);
-    if (d->checkDimensions(row, column))
+    if (d->checkDimensions(row, column) || d->isHiddenByMerge(row, column))
         return false;
 
     Format fmt = format.isValid() ? format : d->cellFormat(row, column);
     d->workbook->styles()->addXfFormat(fmt);
     auto cell = std::make_shared<Cell>(value, Cell::BooleanType, fmt, this);
     d->cellTable.setValue(row, column, cell);
+    d->cellWritten(row, column);
 
     return true;
 }
@@ -888,7 +1002,7 @@ bool Worksheet::writeDateTime(const CellReference &row_column,
 bool Worksheet::writeDateTime(int row, int column, const QDateTime &dt, const Format &format)
 {
     Q_D(Worksheet);
-    if (d->checkDimensions(row, column))
+    if (d->checkDimensions(row, column) || d->isHiddenByMerge(row, column))
         return false;
 
     Format fmt = format.isValid() ? format : d->cellFormat(row, column);
@@ -900,6 +1014,7 @@ bool Worksheet::writeDateTime(int row, int column, const QDateTime &dt, const Fo
 
     auto cell = std::make_shared<Cell>(value, Cell::NumberType, fmt, this);
     d->cellTable.setValue(row, column, cell);
+    d->cellWritten(row, column);
 
     return true;
 }
@@ -917,7 +1032,7 @@ bool Worksheet::writeDate(const CellReference &row_column, const QDate &dt, cons
 bool Worksheet::writeDate(int row, int column, const QDate &dt, const Format &format)
 {
     Q_D(Worksheet);
-    if (d->checkDimensions(row, column))
+    if (d->checkDimensions(row, column) || d->isHiddenByMerge(row, column))
         return false;
 
     Format fmt = format.isValid() ? format : d->cellFormat(row, column);
@@ -931,6 +1046,7 @@ bool Worksheet::writeDate(int row, int column, const QDate &dt, const Format &fo
 
     auto cell = std::make_shared<Cell>(value, Cell::NumberType, fmt, this);
     d->cellTable.setValue(row, column, cell);
+    d->cellWritten(row, column);
 
     return true;
 }
@@ -955,7 +1071,7 @@ bool Worksheet::writeTime(const CellReference &row_column, const QTime &t, const
 bool Worksheet::writeTime(int row, int column, const QTime &t, const Format &format)
 {
     Q_D(Worksheet);
-    if (d->checkDimensions(row, column))
+    if (d->checkDimensions(row, column) || d->isHiddenByMerge(row, column))
         return false;
 
     Format fmt = format.isValid() ? format : d->cellFormat(row, column);
@@ -965,6 +1081,7 @@ bool Worksheet::writeTime(int row, int column, const QTime &t, const Format &for
 
     auto cell = std::make_shared<Cell>(timeToNumber(t), Cell::NumberType, fmt, this);
     d->cellTable.setValue(row, column, cell);
+    d->cellWritten(row, column);
 
     return true;
 }
@@ -998,7 +1115,7 @@ bool Worksheet::writeHyperlink(int row,
                                const QString &tip)
 {
     Q_D(Worksheet);
-    if (d->checkDimensions(row, column))
+    if (d->checkDimensions(row, column) || d->isHiddenByMerge(row, column))
         return false;
 
     // int error = 0;
@@ -1041,6 +1158,7 @@ bool Worksheet::writeHyperlink(int row,
     d->sharedStrings()->addSharedString(displayString);
     auto cell = std::make_shared<Cell>(displayString, Cell::SharedStringType, fmt, this);
     d->cellTable.setValue(row, column, cell);
+    d->cellWritten(row, column);
 
     // Store the hyperlink data in a separate table
     d->urlTable[row][column] = std::make_shared<XlsxHyperlinkData>(
@@ -1083,6 +1201,34 @@ bool Worksheet::addConditionalFormatting(const ConditionalFormatting &cf)
     return true;
 }
 
+/*!
+ * Returns the data validations that apply to the cell (\a row, \a column),
+ * in the order they were added.
+ */
+QList<DataValidation> Worksheet::dataValidationsAt(int row, int column) const
+{
+    Q_D(const Worksheet);
+    QList<DataValidation> validations;
+    const QVector<int> items = d->indexedDataValidations().itemsAt(row, column);
+    for (int idx : items)
+        validations.append(d->dataValidationsList.at(idx));
+    return validations;
+}
+
+/*!
+ * Returns the conditional formattings that apply to the cell (\a row,
+ * \a column), in the order they were added.
+ */
+QList<ConditionalFormatting> Worksheet::conditionalFormattingsAt(int row, int column) const
+{
+    Q_D(const Worksheet);
+    QList<ConditionalFormatting> formattings;
+    const QVector<int> items = d->indexedConditionalFormattings().itemsAt(row, column);
+    for (int idx : items)
+        formattings.append(d->conditionalFormattingList.at(idx));
+    return formattings;
+}
+
 /*!
  * Insert an \a image  at the position \a row, \a column
  * Returns true on success.
@@ -1118,10 +1264,58 @@ int Worksheet::insertImage(int row, int column, const QImage &image)
     return imageIndex;
 }
 
-bool Worksheet::getImage(int imageIndex, QImage &img)
+/*!
+ * \overload
+ * Insert an image at the position \a row, \a column from its encoded PNG,
+ * JPEG, GIF or BMP \a bytes. The bytes are stored as they are, without
+ * decoding and re-encoding the image; only the header is read for the size,
+ * which is placed at 96 dpi. Returns 0 if the format is not recognized.
+ */
+int Worksheet::insertImage(int row, int column, const QByteArray &bytes)
 {
     Q_D(Worksheet);
 
+    QString suffix;
+    if (bytes.startsWith("\x89PNG\r\n\x1a\n"))
+        suffix = QStringLiteral("png");
+    else if (bytes.startsWith("\xff\xd8\xff"))
+        suffix = QStringLiteral("jpeg");
+    else if (bytes.startsWith("GIF87a") || bytes.startsWith("GIF89a"))
+        suffix = QStringLiteral("gif");
+    else if (bytes.startsWith("BM"))
+        suffix = QStringLiteral("bmp");
+    else
+        return 0;
+
+    QBuffer buffer;
+    buffer.setData(bytes);
+    buffer.open(QIODevice::ReadOnly);
+    QImageReader reader(&buffer, suffix.toLatin1());
+    const QSize size = reader.size();
+    if (!size.isValid())
+        return 0;
+
+    if (!d->drawing) {
+        d->drawing = std::make_shared<Drawing>(this, F_NewFromScratch);
+    }
+
+    auto anchor = new DrawingOneCellAnchor(d->drawing.get(), DrawingAnchor::Picture);
+
+    // 96 dpi, the resolution QImage assumes as well
+    const float scale = 36e6F / 3780;
+    anchor->from      = XlsxMarker(row, column, 0, 0);
+    anchor->ext       = QSize(int(size.width() * scale), int(size.height() * scale));
+
+    anchor->setObjectPicture(bytes, suffix, QLatin1String("image/") + suffix);
+
+    return anchor->getm_id();
+}
+
+bool Worksheet::getImage(int imageIndex, QImage &img)
+{
+    // Reading must not mark the sheet modified
+    const WorksheetPrivate *d = static_cast<const Worksheet *>(this)->d_func();
+
     if (imageIndex <= (-1)) {
         return false;
     }
@@ -1144,7 +1338,8 @@ bool Worksheet::getImage(int imageIndex, QImage &img)
 
 bool Worksheet::getImage(int row, int column, QImage &img)
 {
-    Q_D(Worksheet);
+    // Reading must not mark the sheet modified
+    const WorksheetPrivate *d = static_cast<const Worksheet *>(this)->d_func();
 
     if (d->drawing == nullptr) {
         return false;
@@ -1167,7 +1362,8 @@ bool Worksheet::getImage(int row, int column, QImage &img)
 
 uint Worksheet::getImageCount()
 {
-    Q_D(Worksheet);
+    // Reading must not mark the sheet modified
+    const WorksheetPrivate *d = static_cast<const Worksheet *>(this)->d_func();
 
     if (d->drawing == nullptr) {
         return 0;
@@ -1208,7 +1404,7 @@ Chart *Worksheet::insertChart(int row, int column, const QSize &size)
 /*!
         Merge a \a range of cells. The first cell should contain the data and the others should
         be blank. All cells will be applied the same style if a valid \a format is given.
-        Returns true on success.
+        Returns true on success, false if the range overlaps a merged range.
 
         \note All cells except the top-left one will be cleared.
  */
@@ -1221,6 +1417,10 @@ bool Worksheet::mergeCells(const CellRange &range, const Format &format)
     if (d->checkDimensions(range.firstRow(), range.firstColumn()))
         return false;
 
+    // Excel refuses files with overlapping merges
+    if (!d->indexedMerges().itemsIntersecting(range).isEmpty())
+        return false;
+
     if (format.isValid()) {
         d->workbook->styles()->addXfFormat(format);
     }
@@ -1228,7 +1428,7 @@ bool Worksheet::mergeCells(const CellRange &range, const Format &format)
     for (int row = range.firstRow(); row <= range.lastRow(); ++row) {
         for (int col = range.firstColumn(); col <= range.lastColumn(); ++col) {
             if (row == range.firstRow() && col == range.firstColumn()) {
-                auto cell = cellAt(row, col);
+                auto cell = d->detachCell(row, col);
                 if (cell) {
                     if (format.isValid())
                         cell->d_ptr->format = format;
@@ -1252,7 +1452,11 @@ bool Worksheet::mergeCells(const CellRange &range, const Format &format)
 bool Worksheet::unmergeCells(const CellRange &range)
 {
     Q_D(Worksheet);
-    return d->merges.removeOne(range);
+    if (!d->merges.removeOne(range))
+        return false;
+
+    d->mergeIndex.clear();
+    return true;
 }
 
 /*!
@@ -1277,6 +1481,18 @@ QList<CellRange> Worksheet::mergedCells() const
     return emptyList;
 }
 
+/*!
+  Returns the merged range containing the cell (\a row, \a column), or an
+  invalid range if the cell is not merged.
+*/
+CellRange Worksheet::mergedRangeAt(int row, int column) const
+{
+    Q_D(const Worksheet);
+
+    const QVector<int> items = d->indexedMerges().itemsAt(row, column);
+    return items.isEmpty() ? CellRange() : d->merges.at(items.first());
+}
+
 /*!
  * \internal
  */
@@ -1284,6 +1500,7 @@ void Worksheet::saveToXmlFile(QIODevice *device) const
 {
     Q_D(const Worksheet);
     d->relationships->clear();
+    d->recalculateFormulas();
 
     QXmlStreamWriter writer(device);
 
@@ -1491,14 +1708,10 @@ void WorksheetPrivate::saveXmlSheetData(QXmlStreamWriter &writer) const
 {
     calculateSpans();
 
-    for (int row_num = dimension.firstRow(); row_num <= dimension.lastRow(); row_num++) {
+    const QList<int> rows = populatedRows();
+    for (int row_num : rows) {
         auto ctIt = cellTable.cells.constFind(row_num);
         auto riIt = rowsInfo.constFind(row_num);
-        if (ctIt == cellTable.cells.constEnd() && riIt == rowsInfo.constEnd() &&
-            !comments.contains(row_num)) {
-            // Only process rows with cell data / comments / formatting
-            continue;
-        }
 
         int span_index = (row_num - 1) / 16;
         QString span;
@@ -1540,13 +1753,10 @@ void WorksheetPrivate::saveXmlSheetData(QXmlStreamWriter &writer) const
 
         // Write cell data if row contains filled cells
         if (ctIt != cellTable.cells.constEnd()) {
-            for (int col_num = dimension.firstColumn(); col_num <= dimension.lastColumn();
-                 col_num++) {
-                auto cellIt = ctIt->find(col_num);
-                if (cellIt != ctIt->end()) {
-                    saveXmlCellData(writer, row_num, col_num, *cellIt);
-                }
-            }
+            const QList<int> columns =
+                cellTable.sortedColumns(row_num, dimension.firstColumn(), dimension.lastColumn());
+            for (int col_num : columns)
+                saveXmlCellData(writer, row_num, col_num, ctIt->value(col_num));
         }
         writer.writeEndElement(); // row
     }
@@ -1558,10 +1768,11 @@ void WorksheetPrivate::saveXmlCellData(QXmlStreamWriter &writer,
                                        std::shared_ptr<Cell> cell) const
 {
     // This is the innermost loop so efficiency is important.
-    QString cell_pos = CellReference(row, col).toString();
+    QChar cell_pos[CellRefBufferSize];
+    const int cell_pos_length = writeCellRef(cell_pos, row, col);
 
     writer.writeStartElement(QStringLiteral("c"));
-    writer.writeAttribute(QStringLiteral("r"), cell_pos);
+    writer.writeAttribute(QStringLiteral("r"), QString::fromRawData(cell_pos, cell_pos_length));
 
     // Style used by the cell, row or col
     if (!cell->format().isEmpty()) {
@@ -1686,6 +1897,9 @@ void WorksheetPrivate::saveXmlCellData(QXmlStreamWriter &writer,
     } else if (cell->cellType() == Cell::ErrorType) // 'e'
     {
         writer.writeAttribute(QStringLiteral("t"), QStringLiteral("e"));
+        if (cell->hasFormula())
+            cell->formula().saveToXml(writer);
+
         writer.writeTextElement(QStringLiteral("v"), cell->value().toString());
     } else // if (cell->cellType() == Cell::CustomType)
     {
@@ -1706,6 +1920,66 @@ void WorksheetPrivate::saveXmlCellData(QXmlStreamWriter &writer,
     writer.writeEndElement(); // c
 }
 
+static QList<CellRange> rangesOf(const CellRange &range)
+{
+    return QList<CellRange>() << range;
+}
+
+static QList<CellRange> rangesOf(const DataValidation &validation)
+{
+    return validation.ranges();
+}
+
+static QList<CellRange> rangesOf(const ConditionalFormatting &cf)
+{
+    return cf.ranges();
+}
+
+// The lists are only ever appended to, except for unmergeCells(), which
+// clears the merge index
+template <typename T>
+static const RangeIndex &updateRangeIndex(RangeIndex &index, const QList<T> &list)
+{
+    if (index.count() > list.size())
+        index.clear();
+    for (int i = index.count(); i < list.size(); ++i)
+        index.append(rangesOf(list.at(i)));
+    return index;
+}
+
+const RangeIndex &WorksheetPrivate::indexedMerges() const
+{
+    return updateRangeIndex(mergeIndex, merges);
+}
+
+/*
+ * Returns true if (row, column) is covered by a merged range without being
+ * its top-left cell. Excel only shows the top-left cell of a merge, so the
+ * write functions refuse values for the others; writeBlank() still sets
+ * their format, which the borders of a merged range need.
+ */
+bool WorksheetPrivate::isHiddenByMerge(int row, int column) const
+{
+    if (merges.isEmpty())
+        return false;
+
+    const QVector<int> items = indexedMerges().itemsAt(row, column);
+    if (items.isEmpty())
+        return false;
+    const CellRange &range = merges.at(items.first());
+    return row != range.firstRow() || column != range.firstColumn();
+}
+
+const RangeIndex &WorksheetPrivate::indexedDataValidations() const
+{
+    return updateRangeIndex(dataValidationIndex, dataValidationsList);
+}
+
+const RangeIndex &WorksheetPrivate::indexedConditionalFormattings() const
+{
+    return updateRangeIndex(conditionalFormattingIndex, conditionalFormattingList);
+}
+
 void WorksheetPrivate::saveXmlMergeCells(QXmlStreamWriter &writer) const
 {
     if (merges.isEmpty())
@@ -1973,19 +2247,13 @@ bool Worksheet::setColumnHidden(int colFirst, int colLast, bool hidden)
  */
 double Worksheet::columnWidth(int column)
 {
-    Q_D(Worksheet);
+    // Reading must not mark the sheet modified
+    const WorksheetPrivate *d = static_cast<const Worksheet *>(this)->d_func();
 
-    QList<std::shared_ptr<XlsxColumnInfo>> columnInfoList = d->getColumnInfoList(column, column);
-
-    if (columnInfoList.count() == 1) {
+    const XlsxColumnInfo *columnInfo = d->columnInfo(column);
+    if (columnInfo && columnInfo->isSetWidth) {
         // column information is found
-        // qDebug() << "[debug]" << __FUNCTION__ <<  "column (info) is found. " << column <<
-        // oneColWidth;
-        double oneColWidth = columnInfoList.at(0)->width;
-        bool isSetWidth    = columnInfoList.at(0)->isSetWidth;
-        if (isSetWidth) {
-            return oneColWidth;
-        }
+        return columnInfo->width;
     }
 
     // use default width
@@ -1998,11 +2266,11 @@ double Worksheet::columnWidth(int column)
  */
 Format Worksheet::columnFormat(int column)
 {
-    Q_D(Worksheet);
+    // Reading must not mark the sheet modified
+    const WorksheetPrivate *d = static_cast<const Worksheet *>(this)->d_func();
 
-    QList<std::shared_ptr<XlsxColumnInfo>> columnInfoList = d->getColumnInfoList(column, column);
-    if (columnInfoList.count() == 1)
-        return columnInfoList.at(0)->format;
+    if (const XlsxColumnInfo *columnInfo = d->columnInfo(column))
+        return columnInfo->format;
 
     return Format();
 }
@@ -2012,11 +2280,11 @@ Format Worksheet::columnFormat(int column)
  */
 bool Worksheet::isColumnHidden(int column)
 {
-    Q_D(Worksheet);
+    // Reading must not mark the sheet modified
+    const WorksheetPrivate *d = static_cast<const Worksheet *>(this)->d_func();
 
-    QList<std::shared_ptr<XlsxColumnInfo>> columnInfoList = d->getColumnInfoList(column, column);
-    if (columnInfoList.count() == 1)
-        return columnInfoList.at(0)->hidden;
+    if (const XlsxColumnInfo *columnInfo = d->columnInfo(column))
+        return columnInfo->hidden;
 
     return false;
 }
@@ -2081,15 +2349,14 @@ bool Worksheet::setRowHidden(int rowFirst, int rowLast, bool hidden)
 */
 double Worksheet::rowHeight(int row)
 {
-    Q_D(Worksheet);
-    const int min_col = d->dimension.isValid() ? d->dimension.firstColumn() : 1;
+    // Reading must not mark the sheet modified
+    const WorksheetPrivate *d = static_cast<const Worksheet *>(this)->d_func();
 
-    auto it = d->rowsInfo.constFind(row);
-    if (d->checkDimensions(row, min_col, false, true) || it == d->rowsInfo.constEnd()) {
+    const XlsxRowInfo *rowInfo = d->rowInfo(row);
+    if (!rowInfo)
         return d->sheetFormatProps.defaultRowHeight; // return default on invalid row
-    }
 
-    return (*it)->height;
+    return rowInfo->height;
 }
 
 /*!
@@ -2097,13 +2364,14 @@ double Worksheet::rowHeight(int row)
 */
 Format Worksheet::rowFormat(int row)
 {
-    Q_D(Worksheet);
-    const int min_col = d->dimension.isValid() ? d->dimension.firstColumn() : 1;
-    auto it           = d->rowsInfo.constFind(row);
-    if (d->checkDimensions(row, min_col, false, true) || it == d->rowsInfo.constEnd())
+    // Reading must not mark the sheet modified
+    const WorksheetPrivate *d = static_cast<const Worksheet *>(this)->d_func();
+
+    const XlsxRowInfo *rowInfo = d->rowInfo(row);
+    if (!rowInfo)
         return Format(); // return default on invalid row
 
-    return (*it)->format;
+    return rowInfo->format;
 }
 
 /*!
@@ -2111,13 +2379,14 @@ Format Worksheet::rowFormat(int row)
 */
 bool Worksheet::isRowHidden(int row)
 {
-    Q_D(Worksheet);
-    const int min_col = d->dimension.isValid() ? d->dimension.firstColumn() : 1;
-    auto it           = d->rowsInfo.constFind(row);
-    if (d->checkDimensions(row, min_col, false, true) || it == d->rowsInfo.constEnd())
+    // Reading must not mark the sheet modified
+    const WorksheetPrivate *d = static_cast<const Worksheet *>(this)->d_func();
+
+    const XlsxRowInfo *rowInfo = d->rowInfo(row);
+    if (!rowInfo)
         return false; // return default on invalid row
 
-    return (*it)->hidden;
+    return rowInfo->hidden;
 }
 
 /*!
@@ -2274,130 +2543,167 @@ int WorksheetPrivate::colPixelsSize(int col) const
 
 void WorksheetPrivate::loadXmlSheetData(QXmlStreamReader &reader)
 {
-    Q_Q(Worksheet);
-
     Q_ASSERT(reader.name() == QLatin1String("sheetData"));
 
     int row_num = 0;
     int col_num = 0;
 
+    // Formats of the style indices used by the cells, each one is looked up
+    // and checked for a date format only once per sheet. Sized by the styles
+    // table, so an out of range s attribute can not grow it.
+    struct StyleEntry {
+        Format format;
+        bool resolved = false;
+        bool isDate   = false;
+    };
+    QVector<StyleEntry> styleCache(workbook->styles()->xfFormatCount());
+
+    // References to the shared strings, added to the string table at the end
+    QVector<int> sharedStringRefs(sharedStrings()->getSharedStrings().size(), 0);
+
+    // Cells of the current row, inserted into the cell table at the row end
+    QVector<QPair<int, std::shared_ptr<Cell>>> rowCells;
+    int rowCellsRow = 0;
+    auto flushRow   = [&]() {
+        cellTable.setRowValues(rowCellsRow, rowCells);
+        rowCells.clear();
+    };
+
     while (!reader.atEnd() && !(reader.name() == QLatin1String("sheetData") &&
                                 reader.tokenType() == QXmlStreamReader::EndElement)) {
         if (reader.readNextStartElement()) {
             if (reader.name() == QLatin1String("row")) {
-                QXmlStreamAttributes attributes = reader.attributes();
-
-                if (attributes.hasAttribute(QLatin1String("customFormat")) ||
-                    attributes.hasAttribute(QLatin1String("customHeight")) ||
-                    attributes.hasAttribute(QLatin1String("hidden")) ||
-                    attributes.hasAttribute(QLatin1String("outlineLevel")) ||
-                    attributes.hasAttribute(QLatin1String("collapsed"))) {
-
-                    std::shared_ptr<XlsxRowInfo> info(new XlsxRowInfo);
-                    if (attributes.hasAttribute(QLatin1String("customFormat")) &&
-                        attributes.hasAttribute(QLatin1String("s"))) {
-                        int idx      = attributes.value(QLatin1String("s")).toInt();
-                        info->format = workbook->styles()->xfFormat(idx);
+                flushRow();
+
+                // Walk the attributes once instead of looking up each by name
+                int row              = -1;
+                int styleIdx         = -1;
+                bool customFormat    = false;
+                bool hasCustomHeight = false;
+                bool customHeight    = false;
+                bool hasHeight       = false;
+                double height        = 0;
+                bool hidden          = false;
+                bool collapsed       = false;
+                int outlineLevel     = 0;
+
+                const QXmlStreamAttributes attributes = reader.attributes();
+                for (const QXmlStreamAttribute &attribute : attributes) {
+                    const auto name  = attribute.name();
+                    const auto value = attribute.value();
+                    if (name == QLatin1String("r")) {
+                        row = value.toInt();
+                    } else if (name == QLatin1String("s")) {
+                        styleIdx = value.toInt();
+                    } else if (name == QLatin1String("customFormat")) {
+                        customFormat = value == QLatin1String("1");
+                    } else if (name == QLatin1String("customHeight")) {
+                        hasCustomHeight = true;
+                        customHeight    = value == QLatin1String("1");
+                    } else if (name == QLatin1String("ht")) {
+                        hasHeight = true;
+                        height    = value.toDouble();
+                    } else if (name == QLatin1String("hidden")) {
+                        hidden = value == QLatin1String("1");
+                    } else if (name == QLatin1String("collapsed")) {
+                        collapsed = value == QLatin1String("1");
+                    } else if (name == QLatin1String("outlineLevel")) {
+                        outlineLevel = value.toInt();
                     }
+                }
 
-                    if (attributes.hasAttribute(QLatin1String("customHeight"))) {
-                        info->customHeight =
-                            attributes.value(QLatin1String("customHeight")) == QLatin1String("1");
-                        // Row height is only specified when customHeight is set
-                        if (attributes.hasAttribute(QLatin1String("ht"))) {
-                            info->height = attributes.value(QLatin1String("ht")).toDouble();
-                        }
-						else
-                        {
-                            info->customHeight = false;
-                        }
-                    }
-
-                    // both "hidden" and "collapsed" default are false
-                    info->hidden = attributes.value(QLatin1String("hidden")) == QLatin1String("1");
-                    info->collapsed =
-                        attributes.value(QLatin1String("collapsed")) == QLatin1String("1");
-
-                    if (attributes.hasAttribute(QLatin1String("outlineLevel")))
-                        info->outlineLevel =
-                            attributes.value(QLatin1String("outlineLevel")).toInt();
-
-                    //"r" is optional too.
-                    if (attributes.hasAttribute(QLatin1String("r"))) {
-                        int row       = attributes.value(QLatin1String("r")).toInt();
-                        rowsInfo[row] = info;
-                    }
+                // Row height is only specified when customHeight is set
+                if (!hasCustomHeight || !hasHeight) {
+                    customHeight = false;
+                    height       = 0;
+                }
+                const Format rowFormat = customFormat && styleIdx >= 0
+                                             ? workbook->styles()->xfFormat(styleIdx)
+                                             : Format();
+
+                //"r" is optional too. Rows without any custom property get no info.
+                if (row > 0 && (!rowFormat.isEmpty() || customHeight || height != 0 || hidden ||
+                                collapsed || outlineLevel != 0)) {
+                    auto info          = std::make_shared<XlsxRowInfo>(height, rowFormat, hidden);
+                    info->customHeight = customHeight;
+                    info->collapsed    = collapsed;
+                    info->outlineLevel = outlineLevel;
+                    rowsInfo[row]      = info;
                 }
 
-                if (attributes.hasAttribute(QLatin1String("r")))
-                    row_num = attributes.value(QLatin1String("r")).toInt();
+                if (row > 0)
+                    row_num = row;
                 else
                     ++row_num;
-                col_num = 0;
+                col_num     = 0;
+                rowCellsRow = row_num;
 
             } else if (reader.name() == QLatin1String("c")) // Cell
             {
-
-                // Cell
-                QXmlStreamAttributes attributes = reader.attributes();
-                QString r                       = attributes.value(QLatin1String("r")).toString();
-                CellReference pos(r);
-                if (r.isEmpty()) {
+                CellReference pos;
+                qint32 styleIndex       = -1;
+                Cell::CellType cellType = Cell::CustomType;
+                bool hasRef             = false;
+
+                const QXmlStreamAttributes attributes = reader.attributes();
+                for (const QXmlStreamAttribute &attribute : attributes) {
+                    const auto name  = attribute.name();
+                    const auto value = attribute.value();
+                    if (name == QLatin1String("r")) {
+                        hasRef        = !value.isEmpty();
+                        int refRow    = 0;
+                        int refColumn = 0;
+                        if (hasRef && parseCellRef(value, &refRow, &refColumn))
+                            pos = CellReference(refRow, refColumn);
+                    } else if (name == QLatin1String("s")) {
+                        // Style (defined in the styles.xml file)
+                        styleIndex = value.toInt();
+                    } else if (name == QLatin1String("t")) {
+                        // Type
+                        if (value == QLatin1String("s")) // Shared string
+                            cellType = Cell::SharedStringType;
+                        else if (value == QLatin1String("inlineStr")) //  Inline String
+                            cellType = Cell::InlineStringType;
+                        else if (value == QLatin1String("str")) // String
+                            cellType = Cell::StringType;
+                        else if (value == QLatin1String("b")) // Boolean
+                            cellType = Cell::BooleanType;
+                        else if (value == QLatin1String("e")) // Error
+                            cellType = Cell::ErrorType;
+                        else if (value == QLatin1String("d")) // Date
+                            cellType = Cell::DateType;
+                        else if (value == QLatin1String("n")) // Number
+                            cellType = Cell::NumberType;
+                    }
+                }
+                if (!hasRef) {
                     pos.setRow(row_num);
                     pos.setColumn(++col_num);
                 }
 
                 // get format
                 Format format;
-                qint32 styleIndex = -1;
-                if (attributes.hasAttribute(
-                        QLatin1String("s"))) // Style (defined in the styles.xml file)
-                {
-                    //"s" == style index
-                    int idx    = attributes.value(QLatin1String("s")).toInt();
-                    format     = workbook->styles()->xfFormat(idx);
-                    styleIndex = idx;
-                }
-
-                // Cell::CellType cellType = Cell::NumberType;
-                Cell::CellType cellType = Cell::CustomType;
-
-                if (attributes.hasAttribute(QLatin1String("t"))) // Type
-                {
-                    const auto typeString = attributes.value(QLatin1String("t"));
-                    if (typeString == QLatin1String("s")) // Shared string
-                    {
-                        cellType = Cell::SharedStringType;
-                    } else if (typeString == QLatin1String("inlineStr")) //  Inline String
-                    {
-                        cellType = Cell::InlineStringType;
-                    } else if (typeString == QLatin1String("str")) // String
-                    {
-                        cellType = Cell::StringType;
-                    } else if (typeString == QLatin1String("b")) // Boolean
-                    {
-                        cellType = Cell::BooleanType;
-                    } else if (typeString == QLatin1String("e")) // Error
-                    {
-                        cellType = Cell::ErrorType;
-                    } else if (typeString == QLatin1String("d")) // Date
-                    {
-                        cellType = Cell::DateType;
-                    } else if (typeString == QLatin1String("n")) // Number
-                    {
-                        cellType = Cell::NumberType;
-                    } else {
-                        // custom type
-                        cellType = Cell::CustomType;
+                bool isDateFormat = false;
+                // Indices past the styles table have no format, as in xfFormat()
+                if (styleIndex >= 0 && styleIndex < styleCache.size()) {
+                    StyleEntry &style = styleCache[styleIndex];
+                    if (!style.resolved) {
+                        style.format   = workbook->styles()->xfFormat(styleIndex);
+                        style.isDate   = style.format.isValid() && style.format.isDateTimeFormat();
+                        style.resolved = true;
                     }
+                    format       = style.format;
+                    isDateFormat = style.isDate;
                 }
 
-                if (Cell::isDateType(cellType, format)) {
+                if (isDateFormat && (cellType == Cell::NumberType || cellType == Cell::DateType ||
+                                     cellType == Cell::CustomType)) {
                     cellType = Cell::DateType;
                 }
 
                 // create a heap of new cell
-                auto cell = std::make_shared<Cell>(QVariant{}, cellType, format, q, styleIndex);
+                auto cell =
+                    std::make_shared<Cell>(QVariant{}, cellType, format, q_func(), styleIndex);
 
                 while (!reader.atEnd() && !(reader.name() == QLatin1String("c") &&
                                             reader.tokenType() == QXmlStreamReader::EndElement)) {
@@ -2410,13 +2716,17 @@ void WorksheetPrivate::loadXmlSheetData(QXmlStreamReader &reader)
                                 !formula.formulaText().isEmpty()) {
                                 int si               = formula.sharedIndex();
                                 sharedFormulaMap[si] = formula;
+                                sharedFormulaTemplates.remove(si);
                             }
                         } else if (reader.name() == QLatin1String("v")) // Value
                         {
                             QString value = reader.readElementText();
                             if (cellType == Cell::SharedStringType) {
                                 int sst_idx = value.toInt();
-                                sharedStrings()->incRefByStringIndex(sst_idx);
+                                if (sst_idx >= 0 && sst_idx < sharedStringRefs.size())
+                                    ++sharedStringRefs[sst_idx];
+                                else
+                                    sharedStrings()->incRefByStringIndex(sst_idx); // warns
                                 RichString rs          = sharedStrings()->getSharedString(sst_idx);
                                 QString strPlainString = rs.toPlainString();
                                 cell->d_func()->value  = strPlainString;
@@ -2428,14 +2738,8 @@ void WorksheetPrivate::loadXmlSheetData(QXmlStreamReader &reader)
                                 cell->d_func()->value = value.toInt() ? true : false;
                             } else if (cellType == Cell::DateType) {
                                 // [dev54] DateType
-
-                                double dValue    = value.toDouble(); // days from 1900(or 1904)
-                                bool bIsDate1904 = q->workbook()->isDate1904();
-
-                                QVariant vDatetimeValue = datetimeFromNumber(dValue, bIsDate1904);
-                                Q_UNUSED(vDatetimeValue);
-                                // cell->d_func()->value = vDatetimeValue;
-                                cell->d_func()->value = dValue; // dev67
+                                // days from 1900(or 1904), converted when read
+                                cell->d_func()->value = value.toDouble(); // dev67
                             } else {
                                 // ELSE type
                                 cell->d_func()->value = value;
@@ -2463,10 +2767,24 @@ void WorksheetPrivate::loadXmlSheetData(QXmlStreamReader &reader)
                     }
                 }
 
-                cellTable.setValue(pos.row(), pos.column(), cell);
+                // Same test as FormulaEngine::ensureIndexed()
+                const CellFormula &formula = cell->d_func()->formula;
+                if (formula.isValid() && (formula.d->ca || !cell->d_func()->value.isValid()))
+                    uncalculatedFormulas = true;
+
+                if (pos.row() == rowCellsRow)
+                    rowCells.append(qMakePair(pos.column(), cell));
+                else
+                    cellTable.setValue(pos.row(), pos.column(), cell);
             }
         }
     }
+    flushRow();
+
+    for (int i = 0; i < sharedStringRefs.size(); ++i) {
+        if (sharedStringRefs[i] > 0)
+            sharedStrings()->incRefByStringIndex(i, sharedStringRefs[i]);
+    }
 
     if (dimension.lastRow() < row_num)
         dimension.setLastRow(row_num);
@@ -2725,6 +3043,28 @@ QList<std::shared_ptr<XlsxColumnInfo>> WorksheetPrivate::getColumnInfoList(int c
     return columnsInfoList;
 }
 
+/*
+ * Returns the info of \a column, or null if it has none or is out of
+ * range. Unlike getColumnInfoList(), neither splits the column infos nor
+ * extends the dimension, so the getters can use it on a const sheet.
+ */
+const XlsxColumnInfo *WorksheetPrivate::columnInfo(int column) const
+{
+    if (column < 1 || column > XLSX_COLUMN_MAX)
+        return nullptr;
+    return colsInfoHelper.value(column).get();
+}
+
+/*
+ * Returns the info of \a row, or null if it has none or is out of range.
+ */
+const XlsxRowInfo *WorksheetPrivate::rowInfo(int row) const
+{
+    if (row < 1 || row > XLSX_ROW_MAX)
+        return nullptr;
+    return rowsInfo.value(row).get();
+}
+
 QList<std::shared_ptr<XlsxRowInfo>> WorksheetPrivate::getRowInfoList(int rowFirst, int rowLast)
 {
     QList<std::shared_ptr<XlsxRowInfo>> rowInfoList;
@@ -2838,12 +3178,10 @@ bool Worksheet::loadFromXmlFile(QIODevice *device)
  */
 void WorksheetPrivate::validateDimension()
 {
-    if (dimension.isValid() || cellTable.isEmpty())
+    if (dimension.isValid())
         return;
 
-    CellRange cr(
-        cellTable.firstRow, cellTable.firstColumn, cellTable.lastRow, cellTable.lastColumn);
-
+    const CellRange cr = cellTable.bounds();
     if (cr.isValid())
         dimension = cr;
 }
@@ -2879,29 +3217,22 @@ QVector<CellLocation> Worksheet::getFullCells(int *maxRow, int *maxCol) const
         return ret;
     }
 
+    const CellRange bounds = d->cellTable.bounds();
+    if (!bounds.isValid())
+        return ret;
+    (*maxRow) = bounds.lastRow();
+    (*maxCol) = bounds.lastColumn();
+    ret.reserve(d->cellTable.count());
+
     const auto sortedRows = d->cellTable.sortedRows();
     for (const auto row : sortedRows) {
         const auto &columns      = d->cellTable.cells[row];
-        const auto columnsSorted = CellTable::sorteIntList(columns.keys());
+        const auto columnsSorted = d->cellTable.sortedColumns(row);
         for (const auto &col : columnsSorted) {
-            // It's faster to iterate but cellTable is unordered which might not
-            // be what callers want?
-            auto cell = std::make_shared<Cell>(columns.value(col).get());
-
             CellLocation cl;
-
-            cl.row = row;
-            if (row > (*maxRow)) {
-                (*maxRow) = row;
-            }
-
-            cl.col = col;
-            if (col > (*maxCol)) {
-                (*maxCol) = col;
-            }
-
-            cl.cell = cell;
-
+            cl.row  = row;
+            cl.col  = col;
+            cl.cell = std::make_shared<Cell>(columns.value(col).get());
             ret.push_back(cl);
         }
     }
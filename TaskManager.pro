@@ -1,4 +1,4 @@
-QT       += core gui sql charts widgets printsupport
+QT       += core gui sql charts widgets printsupport concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -20,20 +20,24 @@ SOURCES += \
     aboutdialog.cpp \
     main.cpp \
     mainwindow.cpp \
+    refreshscheduler.cpp \
     remindersettingdialog.cpp \
     reminderthread.cpp \
     taskdbmanager.cpp \
     taskdialog.cpp \
-    taskstatistic.cpp
+    taskstatistic.cpp \
+    tasktablemodel.cpp
 
 HEADERS += \
     aboutdialog.h \
     mainwindow.h \
+    refreshscheduler.h \
     remindersettingdialog.h \
     reminderthread.h \
     taskdbmanager.h \
     taskdialog.h \
-    taskstatistic.h
+    taskstatistic.h \
+    tasktablemodel.h
 
 FORMS += \
     aboutdialog.ui \
@@ -5,6 +5,13 @@
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+
+    // --benchmark：只跑数据库查询的性能基准，不启动界面（QXlsx的基准见QXlsx/benchmark）
+    if (a.arguments().contains("--benchmark")) {
+        TaskDBManager::getInstance()->benchmarkQueries();
+        return 0;
+    }
+
     MainWindow w;
     w.show();
     return a.exec();
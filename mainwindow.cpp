@@ -17,6 +17,13 @@
 #include <QFileDialog>
 #include <QPrinter>
 #include <QPieSeries>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QRegularExpression>
+#include <algorithm>
+#include <functional>
 #include <QDebug>
 
 using namespace QXlsx;
@@ -56,10 +63,6 @@ MainWindow::MainWindow(QWidget *parent)
         QMessageBox::critical(this, "错误", "数据库连接失败！");
     }
 
-    QTimer *statusTimer = new QTimer(this);
-    statusTimer->start(60000);
-    connect(statusTimer, &QTimer::timeout, this, &MainWindow::updateLatestTaskStatus);
-
 }
 
 void MainWindow::initUI()
@@ -151,6 +154,8 @@ void MainWindow::initMenuBar()
 
     // 文件菜单
     QMenu *fileMenu = menuBar->addMenu(tr("文件(&F)"));
+    QAction *importAct = fileMenu->addAction("导入任务(&I)");
+    fileMenu->addSeparator();
     QAction *exportExcelAct = fileMenu->addAction("导出Excel(&E)");
     QAction *exportPdfAct = fileMenu->addAction("导出PDF(&P)");
     fileMenu->addSeparator();
@@ -176,6 +181,7 @@ void MainWindow::initMenuBar()
     connect(deleteAct, &QAction::triggered, this, &MainWindow::onDeleteTask);
     connect(reminderThresholdAct, &QAction::triggered, this, &MainWindow::onSetReminderThreshold);
     connect(sortAct, &QAction::triggered, this, &MainWindow::onSortByPriority);
+    connect(importAct, &QAction::triggered, this, &MainWindow::onImportTasks);
     connect(exportExcelAct, &QAction::triggered, this, &MainWindow::onExportExcel);
     connect(exportPdfAct, &QAction::triggered, this, &MainWindow::onExportPdf);
     connect(aboutAct, &QAction::triggered, this, &MainWindow::onAbout);
@@ -197,6 +203,18 @@ void MainWindow::initToolBar()
     toolBar->addSeparator();
     QAction *reminderSettingAct = toolBar->addAction("提醒设置");
     QAction *exportAct = toolBar->addAction(QIcon::fromTheme("document-export"), tr("导出报表"));
+    toolBar->addSeparator();
+
+    // 搜索框：输入停顿后自动检索
+    m_searchEdit = new QLineEdit(toolBar);
+    m_searchEdit->setPlaceholderText("搜索任务标题/描述");
+    m_searchEdit->setClearButtonEnabled(true);
+    m_searchEdit->setMaximumWidth(260);
+    toolBar->addWidget(m_searchEdit);
+
+    m_searchTimer = new QTimer(this);
+    m_searchTimer->setSingleShot(true);
+    m_searchTimer->setInterval(150);
 
     connect(addAct, &QAction::triggered, this, &MainWindow::onAddTask);
     connect(editAct, &QAction::triggered, this, &MainWindow::onEditTask);
@@ -205,35 +223,26 @@ void MainWindow::initToolBar()
     connect(refreshAct, &QAction::triggered, this, &MainWindow::onRefresh);
     connect(reminderSettingAct, &QAction::triggered, this, &MainWindow::onSetReminderThreshold);
     connect(exportAct, &QAction::triggered, this, &MainWindow::onExportExcel);
+    connect(m_searchEdit, &QLineEdit::textChanged, m_searchTimer, qOverload<>(&QTimer::start));
+    connect(m_searchEdit, &QLineEdit::returnPressed, this, &MainWindow::onSearch);
+    connect(m_searchTimer, &QTimer::timeout, this, &MainWindow::onSearch);
 }
 
 void MainWindow::initTaskTable()
 {
-    // 使用QSqlTableModel绑定数据库表
-    m_taskModel = new QSqlTableModel(this, TaskDBManager::getInstance()->getDB());
-    m_taskModel->setTable("tasks");
-    m_taskModel->setEditStrategy(QSqlTableModel::OnManualSubmit);
-    m_taskModel->setSort(m_taskModel->fieldIndex("update_time"), Qt::DescendingOrder);
-    if(m_taskModel->select()){
-        qDebug() << "实际执行的 SQL：" << m_taskModel->query().lastQuery();
-        qDebug() << "表格加载行数：" << m_taskModel->rowCount();
-    }
-
-    // 自定义表头
-    m_taskModel->setHeaderData(m_taskModel->fieldIndex("id"), Qt::Horizontal, "ID");
-    m_taskModel->setHeaderData(m_taskModel->fieldIndex("title"), Qt::Horizontal, "任务标题");
-    m_taskModel->setHeaderData(m_taskModel->fieldIndex("category"), Qt::Horizontal, "分类");
-    m_taskModel->setHeaderData(m_taskModel->fieldIndex("priority"), Qt::Horizontal, "优先级");
-    m_taskModel->setHeaderData(m_taskModel->fieldIndex("deadline"), Qt::Horizontal, "截止时间");
-    m_taskModel->setHeaderData(m_taskModel->fieldIndex("is_completed"), Qt::Horizontal, "完成状态");
-    m_taskModel->setHeaderData(m_taskModel->fieldIndex("description"), Qt::Horizontal, "描述");
+    // 列式快照模型：数据取自任务缓存，增删改逐行更新
+    m_taskModel = new TaskTableModel(this);
+    m_taskModel->reload();
 
     // 绑定到表格
     m_taskTableView->setModel(m_taskModel);
 
-    // 隐藏不需要的字段
-    m_taskTableView->hideColumn(m_taskModel->fieldIndex("create_time"));
-    m_taskTableView->hideColumn(m_taskModel->fieldIndex("update_time"));
+    // 点击表头在内存中排序（不启用setSortingEnabled，避免绑定时按第0列重排）
+    QHeaderView *header = m_taskTableView->horizontalHeader();
+    header->setSectionsClickable(true);
+    header->setSortIndicatorShown(true);
+    header->setSortIndicator(TaskTableModel::kDefaultOrder, Qt::DescendingOrder);
+    connect(header, &QHeaderView::sortIndicatorChanged, m_taskModel, &TaskTableModel::sort);
 }
 
 void MainWindow::initCategoryList()
@@ -261,9 +270,11 @@ void MainWindow::initStatPanel()
     QVBoxLayout *baseLayout = new QVBoxLayout(baseStatWidget);
     m_totalLabel = new QLabel("总任务数：0", baseStatWidget);
     m_unfinishedLabel = new QLabel("未完成数：0", baseStatWidget);
+    m_overdueLabel = new QLabel("逾期数：0", baseStatWidget);
     m_rateLabel = new QLabel("完成率：0%", baseStatWidget);
     baseLayout->addWidget(m_totalLabel);
     baseLayout->addWidget(m_unfinishedLabel);
+    baseLayout->addWidget(m_overdueLabel);
     baseLayout->addWidget(m_rateLabel);
     statLayout->addWidget(baseStatWidget);
 
@@ -273,12 +284,60 @@ void MainWindow::initStatPanel()
     m_completionBar->setValue(0);
     statLayout->addWidget(m_completionBar);
 
-    // 4. 分类饼图
-    m_pieChartView = new QChartView(m_statWidget);
+    // 4. 分类饼图（图表对象只创建一次，刷新时原地更新扇区）
+    m_pieSeries = new QPieSeries();
+    QChart *pieChart = new QChart();
+    pieChart->addSeries(m_pieSeries);
+    pieChart->setTitle("任务分类占比");
+    pieChart->legend()->setAlignment(Qt::AlignBottom);
+    m_pieChartView = new QChartView(pieChart, m_statWidget);
+    m_pieChartView->setRenderHint(QPainter::Antialiasing);
     m_pieChartView->setMinimumHeight(200);
     statLayout->addWidget(m_pieChartView);
 
-    // 5. 占位符
+    // 5. 完成趋势（数据来自按日预聚合表）
+    m_trendRangeBox = new QComboBox(m_statWidget);
+    m_trendRangeBox->addItem("近30天（按日）");
+    m_trendRangeBox->addItem("近一年（按周）");
+    connect(m_trendRangeBox, &QComboBox::currentIndexChanged, this, [this](int index) {
+        m_refreshScheduler->setTrendWeekly(index == 1);
+    });
+    statLayout->addWidget(m_trendRangeBox);
+
+    m_createdSeries = new QLineSeries();
+    m_createdSeries->setName("新建");
+    m_completedSeries = new QLineSeries();
+    m_completedSeries->setName("完成");
+    m_overdueSeries = new QLineSeries();
+    m_overdueSeries->setName("逾期");
+    QChart *trendChart = new QChart();
+    trendChart->addSeries(m_createdSeries);
+    trendChart->addSeries(m_completedSeries);
+    trendChart->addSeries(m_overdueSeries);
+    trendChart->setTitle("任务完成趋势");
+    trendChart->legend()->setAlignment(Qt::AlignBottom);
+
+    m_trendAxisX = new QDateTimeAxis();
+    m_trendAxisX->setFormat("MM-dd");
+    trendChart->addAxis(m_trendAxisX, Qt::AlignBottom);
+    m_trendAxisY = new QValueAxis();
+    m_trendAxisY->setLabelFormat("%d");
+    trendChart->addAxis(m_trendAxisY, Qt::AlignLeft);
+    for (QAbstractSeries *series : trendChart->series()) {
+        series->attachAxis(m_trendAxisX);
+        series->attachAxis(m_trendAxisY);
+    }
+
+    m_trendChartView = new QChartView(trendChart, m_statWidget);
+    m_trendChartView->setRenderHint(QPainter::Antialiasing);
+    m_trendChartView->setMinimumHeight(200);
+    statLayout->addWidget(m_trendChartView);
+
+    // 刷新调度器：合并短时间内的刷新请求，统计查询在后台线程执行
+    m_refreshScheduler = new RefreshScheduler(this);
+    connect(m_refreshScheduler, &RefreshScheduler::refreshReady, this, &MainWindow::applyRefresh);
+
+    // 6. 占位符
     statLayout->addStretch();
 }
 
@@ -294,14 +353,23 @@ void MainWindow::initReminderThread()
         qDebug() << "❌ 提醒线程已结束（退出run()函数）";
     });
 
-    // 2. 绑定提醒信号（跨线程必须加QueuedConnection）
+    // 2. 提醒先排队，合并窗口结束后统一展示，避免短时间内大量提醒叠加弹窗
+    m_reminderFlushTimer = new QTimer(this);
+    m_reminderFlushTimer->setSingleShot(true);
+    m_reminderFlushTimer->setInterval(1000);
+    connect(m_reminderFlushTimer, &QTimer::timeout, this, &MainWindow::flushReminders);
+
+    // 绑定提醒信号（跨线程必须加QueuedConnection）
     connect(m_reminderThread, &ReminderThread::reminder,
             this, &MainWindow::onTaskReminder,
             Qt::QueuedConnection);
 
-    // 新增：任务状态变化时，自动更新最近任务状态栏
-    connect(m_reminderThread, &ReminderThread::taskStatusChanged,
-            this, &MainWindow::updateLatestTaskStatus, Qt::QueuedConnection);
+    // 最近任务状态栏：由提醒线程推送最近截止任务，界面只做倒计时
+    m_countdownTimer = new QTimer(this);
+    m_countdownTimer->setSingleShot(true);
+    connect(m_countdownTimer, &QTimer::timeout, this, &MainWindow::updateLatestTaskStatus);
+    connect(m_reminderThread, &ReminderThread::nextDeadlineChanged,
+            this, &MainWindow::onNextDeadlineChanged, Qt::QueuedConnection);
 
     // 3. 启动线程
     m_reminderThread->start();
@@ -316,22 +384,9 @@ void MainWindow::updateStatusBar(int total, int unfinished)
     }
 }
 
-int MainWindow::countUnfinished(const QList<Task>& tasks)
-{
-    int count = 0;
-    for (const Task& task : tasks) {
-        if (!task.isCompleted) count++;
-    }
-    return count;
-}
-
-void MainWindow::refreshStatPanel()
+void MainWindow::updateStatPanel()
 {
-
-    QList<Task> allTasks = TaskDBManager::getInstance()->getAllTasks();
-    qDebug() << "统计时查询到的任务数：" << allTasks.size();
-
-    // 获取统计数据
+    // 获取统计数据（来自统计引擎的增量计数，开销只与分类数有关）
     int total, unfinished;
     TaskStatistic::statTotal(total, unfinished);
     float rate = TaskStatistic::getCompletionRate() * 100;
@@ -340,56 +395,101 @@ void MainWindow::refreshStatPanel()
     // 更新基础统计
     m_totalLabel->setText(QString("总任务数：%1").arg(total));
     m_unfinishedLabel->setText(QString("未完成数：%1").arg(unfinished));
+    m_overdueLabel->setText(QString("逾期数：%1").arg(TaskStatistic::statOverdue()));
     m_rateLabel->setText(QString("完成率：%1%").arg(QString::number(rate, 'f', 1)));
     m_completionBar->setValue((int)rate);
 
-    // 更新饼图
-    QPieSeries *series = new QPieSeries();
-    for (auto it = statMap.begin(); it != statMap.end(); ++it) {
+    // 更新饼图：已有分类只改数值，新分类追加扇区，消失的分类移除扇区
+    for (auto it = m_pieSlices.begin(); it != m_pieSlices.end();) {
+        if (!statMap.contains(it.key())) {
+            m_pieSeries->remove(it.value()); // remove会释放扇区
+            it = m_pieSlices.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = statMap.cbegin(); it != statMap.cend(); ++it) {
         int count = it.value().first + it.value().second;
-        series->append(it.key(), count);
+        QPieSlice *slice = m_pieSlices.value(it.key());
+        if (slice) {
+            if (slice->value() != count) slice->setValue(count);
+        } else {
+            m_pieSlices.insert(it.key(), m_pieSeries->append(it.key(), count));
+        }
     }
 
-    // 饼图样式
-    QChart *chart = new QChart();
-    chart->addSeries(series);
-    chart->setTitle("任务分类占比");
-    chart->legend()->setAlignment(Qt::AlignBottom);
-    m_pieChartView->setChart(chart);
-    m_pieChartView->setRenderHint(QPainter::Antialiasing);
-
     // 更新状态栏
     updateStatusBar(total, unfinished);
 }
 
+void MainWindow::applyRefresh(const RefreshResult& result)
+{
+    // 各视图的数据在同一次事件处理中一起更新
+    if (result.flags & RefreshScheduler::DirtyTable) {
+        m_taskModel->reload();
+    }
+    // 计数平时由统计引擎增量维护，只有显式刷新时整体重置，到期时只更新逾期数
+    TaskStatEngine *engine = TaskStatEngine::getInstance();
+    if (result.flags & RefreshScheduler::DirtyAggregates) {
+        engine->applyAggregates(result.aggregates);
+    } else if (result.flags & RefreshScheduler::DirtyOverdue) {
+        engine->applyOverdue(result.overdue);
+    }
+    if (result.flags & (RefreshScheduler::DirtyCounts | RefreshScheduler::DirtyOverdue
+                        | RefreshScheduler::DirtyAggregates)) {
+        updateStatPanel();
+    }
+    if (result.flags & RefreshScheduler::DirtyTrend) {
+        updateTrendChart(result.trend, result.trendFrom, result.trendTo);
+    }
+}
+
+void MainWindow::updateTrendChart(const QList<TaskTrendPoint>& points, const QDate& from, const QDate& to)
+{
+    QList<QPointF> createdPoints, completedPoints, overduePoints;
+    createdPoints.reserve(points.size());
+    completedPoints.reserve(points.size());
+    overduePoints.reserve(points.size());
+    int maxValue = 1;
+    for (const TaskTrendPoint& point : points) {
+        qreal x = QDateTime(point.start, QTime(0, 0)).toMSecsSinceEpoch();
+        createdPoints.append(QPointF(x, point.created));
+        completedPoints.append(QPointF(x, point.completed));
+        overduePoints.append(QPointF(x, point.overdue));
+        maxValue = qMax(maxValue, qMax(point.created, qMax(point.completed, point.overdue)));
+    }
+
+    // replace整体替换点集，每条折线只触发一次重绘
+    m_createdSeries->replace(createdPoints);
+    m_completedSeries->replace(completedPoints);
+    m_overdueSeries->replace(overduePoints);
+    m_trendAxisX->setRange(QDateTime(from, QTime(0, 0)), QDateTime(to, QTime(0, 0)));
+    m_trendAxisY->setRange(0, maxValue);
+}
+
+void MainWindow::onNextDeadlineChanged(int taskId, const QString& title, const QDateTime& deadline)
+{
+    m_nextTaskId = taskId;
+    m_nextTaskTitle = title;
+    m_nextTaskDeadline = deadline;
+    updateLatestTaskStatus();
+}
+
 void MainWindow::updateLatestTaskStatus()
 {
     QLabel *latestTaskLabel = statusBar()->findChild<QLabel*>("latestTaskLabel");
     if (!latestTaskLabel) return;
 
-    QDateTime now = QDateTime::currentDateTime();
-    Task latestTask;
-    int retryCount = 0;
-
-    // 强制重试3次，确保找到有效任务
-    while (retryCount < 3) {
-        latestTask = TaskDBManager::getInstance()->getLatestTask();
-        // 校验任务是否有效（未逾期）
-        if (latestTask.id != -1 && latestTask.deadline > now) {
-            break;
-        }
-        retryCount++;
-        QThread::msleep(100); // 短暂等待后重试
-    }
-
-    // 情况1：无有效任务
-    if (latestTask.id == -1) {
+    // 情况1：无待截止任务（截止后提醒线程会推送下一个任务）
+    m_countdownTimer->stop();
+    if (m_nextTaskId == -1) {
         latestTaskLabel->setText("最近任务：无");
         return;
     }
 
-    // 情况2：有效任务，计算剩余时间
-    qint64 diffSeconds = now.secsTo(latestTask.deadline);
+    // 情况2：计算剩余时间（不足1分钟按0分钟显示）
+    qint64 remainMs = qMax<qint64>(0, QDateTime::currentDateTime().msecsTo(m_nextTaskDeadline));
+    qint64 diffSeconds = remainMs / 1000;
     int hours = diffSeconds / 3600;
     int minutes = (diffSeconds % 3600) / 60;
     QString timeText = (hours > 0) ?
@@ -397,8 +497,14 @@ void MainWindow::updateLatestTaskStatus()
                            QString("%1分钟").arg(minutes);
 
     latestTaskLabel->setText(
-        QString("最近任务：「%1」 剩余 %2").arg(latestTask.title).arg(timeText)
+        QString("最近任务：「%1」 剩余 %2").arg(m_nextTaskTitle).arg(timeText)
         );
+
+    // 倒计时：在剩余分钟数下一次变化时刷新
+    if (remainMs > 0) {
+        qint64 untilNextMinute = remainMs % 60000;
+        m_countdownTimer->start(int(untilNextMinute > 0 ? untilNextMinute : 60000));
+    }
 }
 
 void MainWindow::initSystemTray()
@@ -466,7 +572,6 @@ void MainWindow::onAddTask()
         Task task = dlg.getTask();
         if (TaskDBManager::getInstance()->addTask(task)) {
             QMessageBox::information(this, "提示", "任务新增成功！");
-            onRefresh();
         } else {
             QMessageBox::critical(this, "错误", "任务新增失败！");
         }
@@ -481,7 +586,7 @@ void MainWindow::onEditTask()
         return;
     }
 
-    int taskId = m_taskModel->data(m_taskModel->index(index.row(), 0)).toInt();
+    int taskId = m_taskModel->taskIdAt(index.row());
     Task task = TaskDBManager::getInstance()->getTaskById(taskId);
 
     TaskDialog dlg(true, task); // 编辑模式
@@ -489,7 +594,6 @@ void MainWindow::onEditTask()
         Task updatedTask = dlg.getTask();
         if (TaskDBManager::getInstance()->updateTask(updatedTask)) {
             QMessageBox::information(this, "提示", "任务编辑成功！");
-            onRefresh();
         }
     }
 }
@@ -506,10 +610,9 @@ void MainWindow::onDeleteTask()
         return;
     }
 
-    int taskId = m_taskModel->data(m_taskModel->index(curIndex.row(), m_taskModel->fieldIndex("id"))).toInt();
+    int taskId = m_taskModel->taskIdAt(curIndex.row());
     if (TaskDBManager::getInstance()->deleteTask(taskId)) {
         QMessageBox::information(this, "提示", "任务删除成功！");
-        onRefresh();
     } else {
         QMessageBox::critical(this, "错误", "任务删除失败！");
     }
@@ -517,22 +620,14 @@ void MainWindow::onDeleteTask()
 
 void MainWindow::onSortByPriority()
 {
-    m_taskModel->setSort(m_taskModel->fieldIndex("priority"), Qt::DescendingOrder);
-    m_taskModel->select();
+    // 通过表头排序指示器触发，表头箭头与实际排序保持一致
+    m_taskTableView->horizontalHeader()->setSortIndicator(TaskTableModel::ColPriority, Qt::DescendingOrder);
 }
 
 void MainWindow::onRefresh()
 {
-    m_taskModel->select();
-
-    refreshStatPanel();
-
-    updateLatestTaskStatus();
-
-    // 更新状态栏统计
-    QList<Task> allTasks = TaskDBManager::getInstance()->getAllTasks();
-    QList<Task> uncompletedTasks = TaskDBManager::getInstance()->getUncompletedTasks();
-    updateStatusBar(allTasks.size(), uncompletedTasks.size());
+    // 显式刷新：重新加载列表并重置统计；增删改不走这里，列表逐行更新、统计由tasksChanged驱动
+    m_refreshScheduler->markDirty(RefreshScheduler::DirtyAll);
 }
 
 void MainWindow::onAbout()
@@ -541,6 +636,176 @@ void MainWindow::onAbout()
     dlg.exec();
 }
 
+// 解析CSV文本（支持引号包裹的字段、字段内的逗号/换行以及""转义）
+static QList<QStringList> parseCsv(const QString& text)
+{
+    QList<QStringList> rows;
+    QStringList row;
+    QString field;
+    bool inQuotes = false;
+
+    for (int i = 0; i < text.size(); ++i) {
+        QChar ch = text.at(i);
+        if (inQuotes) {
+            if (ch == '"') {
+                if (i + 1 < text.size() && text.at(i + 1) == '"') {
+                    field.append('"');
+                    ++i;
+                } else {
+                    inQuotes = false;
+                }
+            } else {
+                field.append(ch);
+            }
+        } else if (ch == '"') {
+            inQuotes = true;
+        } else if (ch == ',') {
+            row.append(field);
+            field.clear();
+        } else if (ch == '\n' || ch == '\r') {
+            if (ch == '\r' && i + 1 < text.size() && text.at(i + 1) == '\n') ++i;
+            row.append(field);
+            field.clear();
+            rows.append(row);
+            row.clear();
+        } else {
+            field.append(ch);
+        }
+    }
+    if (!field.isEmpty() || !row.isEmpty()) {
+        row.append(field);
+        rows.append(row);
+    }
+    return rows;
+}
+
+// 截止时间兼容：Excel日期单元格直接取QDateTime，文本按导出格式解析
+static QDateTime parseImportDateTime(const QVariant& value)
+{
+    if (value.userType() == QMetaType::QDateTime) return value.toDateTime();
+
+    QString text = value.toString().trimmed().replace("T", " ");
+    QDateTime dateTime = QDateTime::fromString(text, "yyyy-MM-dd HH:mm:ss");
+    if (!dateTime.isValid()) dateTime = QDateTime::fromString(text, "yyyy-MM-dd HH:mm");
+    if (!dateTime.isValid()) dateTime = QDateTime::fromString(text, Qt::ISODate);
+    return dateTime;
+}
+
+// 一行数据转任务，列顺序与导出Excel一致：ID、标题、分类、优先级、截止时间、完成状态、描述、提前提醒；
+// 提前提醒为空（包括没有该列的旧文件）时hasOffsets为false，更新已有任务时保留其原有设置
+static bool importRowToTask(const QVariantList& cells, Task& task, bool& hasOffsets)
+{
+    auto cell = [&cells](int col) { return col < cells.size() ? cells.at(col) : QVariant(); };
+
+    task.id = cell(0).toInt();
+    if (task.id <= 0) task.id = -1;
+    task.title = cell(1).toString().trimmed();
+    if (task.title.isEmpty()) return false;
+
+    QString category = cell(2).toString().trimmed();
+    if (!category.isEmpty()) task.category = category;
+    int priority = cell(3).toInt();
+    if (priority >= 1 && priority <= 5) task.priority = priority;
+
+    task.deadline = parseImportDateTime(cell(4));
+    if (!task.deadline.isValid()) return false;
+
+    QString status = cell(5).toString().trimmed();
+    task.isCompleted = (status == "已完成" || status == "1" || status.compare("true", Qt::CaseInsensitive) == 0);
+    task.description = cell(6).toString().trimmed();
+
+    // 与任务对话框相同：中英文逗号/空格分隔，忽略无效值，去重后从大到小排列
+    const QStringList parts = cell(7).toString().split(QRegularExpression("[,，\\s]+"), Qt::SkipEmptyParts);
+    for (const QString& part : parts) {
+        int minutes = part.toInt();
+        if (minutes > 0 && !task.reminderOffsets.contains(minutes)) task.reminderOffsets.append(minutes);
+    }
+    std::sort(task.reminderOffsets.begin(), task.reminderOffsets.end(), std::greater<int>());
+    hasOffsets = !task.reminderOffsets.isEmpty();
+    return true;
+}
+
+void MainWindow::onImportTasks()
+{
+    QString filePath = QFileDialog::getOpenFileName(this, "导入任务", "", "任务文件 (*.xlsx *.csv)");
+    if (filePath.isEmpty()) return;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // 1. 读取文件中的所有行（首行为表头）
+    QList<QVariantList> rows;
+    if (QFileInfo(filePath).suffix().compare("csv", Qt::CaseInsensitive) == 0) {
+        QFile file(filePath);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            QMessageBox::critical(this, "错误", "无法打开文件：" + file.errorString());
+            return;
+        }
+        QTextStream in(&file);
+        const QList<QStringList> csvRows = parseCsv(in.readAll());
+        for (int i = 1; i < csvRows.size(); ++i) {
+            QVariantList cells;
+            for (const QString& field : csvRows.at(i)) cells.append(field);
+            rows.append(cells);
+        }
+    } else {
+        QXlsx::Document xlsx(filePath);
+        if (!xlsx.load()) {
+            QMessageBox::critical(this, "错误", "无法读取Excel文件！");
+            return;
+        }
+        int lastRow = xlsx.dimension().lastRow();
+        for (int row = 2; row <= lastRow; ++row) {
+            QVariantList cells;
+            for (int col = 1; col <= 8; ++col) cells.append(xlsx.read(row, col));
+            rows.append(cells);
+        }
+    }
+
+    // 2. 已存在的ID走批量更新，其余走批量新增；记下已有任务的提前提醒，文件中没填时沿用
+    QHash<int, QList<int>> existingOffsets;
+    for (const Task& task : TaskDBManager::getInstance()->getAllTasks()) {
+        existingOffsets.insert(task.id, task.reminderOffsets);
+    }
+
+    QList<Task> newTasks, changedTasks;
+    int skipped = 0;
+    for (const QVariantList& cells : rows) {
+        Task task;
+        bool hasOffsets = false;
+        if (!importRowToTask(cells, task, hasOffsets)) {
+            skipped++;
+            continue;
+        }
+        auto existing = existingOffsets.constFind(task.id);
+        if (task.id != -1 && existing != existingOffsets.constEnd()) {
+            if (!hasOffsets) task.reminderOffsets = existing.value();
+            changedTasks.append(task);
+        } else {
+            task.id = -1;
+            newTasks.append(task);
+        }
+    }
+
+    if (newTasks.isEmpty() && changedTasks.isEmpty()) {
+        QMessageBox::warning(this, "提示", "文件中没有可导入的任务！");
+        return;
+    }
+
+    // 3. 新增和更新在同一个事务内写入，失败时整体回滚
+    if (!TaskDBManager::getInstance()->importTasks(newTasks, changedTasks)) {
+        QMessageBox::critical(this, "错误", "任务导入失败！");
+        return;
+    }
+
+    qint64 elapsed = timer.elapsed();
+    qDebug() << "导入完成：新增" << newTasks.size() << "条，更新" << changedTasks.size()
+             << "条，跳过" << skipped << "条，耗时" << elapsed << "ms";
+    QMessageBox::information(this, "提示",
+                             QString("导入完成：新增 %1 条，更新 %2 条，跳过 %3 条（耗时 %4 ms）")
+                                 .arg(newTasks.size()).arg(changedTasks.size()).arg(skipped).arg(elapsed));
+}
+
 void MainWindow::onExportExcel()
 {
     QString filePath = QFileDialog::getSaveFileName(this, "导出Excel", "任务统计.xlsx", "Excel文件 (*.xlsx)");
@@ -555,6 +820,7 @@ void MainWindow::onExportExcel()
     xlsx.write("E1", "截止时间");
     xlsx.write("F1", "完成状态");
     xlsx.write("G1", "描述");
+    xlsx.write("H1", "提前提醒(分钟)");
 
     // 数据
     QList<Task> tasks = TaskDBManager::getInstance()->getAllTasks();
@@ -567,6 +833,9 @@ void MainWindow::onExportExcel()
         xlsx.write(row, 5, task.deadline.toString("yyyy-MM-dd HH:mm"));
         xlsx.write(row, 6, task.isCompleted ? "已完成" : "未完成");
         xlsx.write(row, 7, task.description);
+        QStringList offsets;
+        for (int minutes : task.reminderOffsets) offsets << QString::number(minutes);
+        xlsx.write(row, 8, offsets.join(","));
         row++;
     }
 
@@ -622,26 +891,43 @@ void MainWindow::onExportPdf()
 
 void MainWindow::onCategoryChanged(const QString& category)
 {
+    // 清空或切换筛选分类，模型按当前排序重新加载（按更新时间/优先级排序时只取第一页）
+    m_taskModel->setCategory(category == "全部任务" ? QString() : category);
+
+    // 更新统计（直接读统计引擎的计数）
     if (category == "全部任务") {
-        m_taskModel->setFilter(""); // 清空筛选
+        int total, unfinished;
+        TaskStatistic::statTotal(total, unfinished);
+        updateStatusBar(total, unfinished);
     } else {
-        m_taskModel->setFilter(QString("category = '%1'").arg(category));
+        QPair<int, int> count = TaskStatistic::statByCategory().value(category);
+        updateStatusBar(count.first + count.second, count.second);
     }
-    m_taskModel->select();
+}
 
-    // 更新统计
-    if (category == "全部任务") {
-        QList<Task> allTasks = TaskDBManager::getInstance()->getAllTasks();
-        QList<Task> uncompletedTasks = TaskDBManager::getInstance()->getUncompletedTasks();
-        updateStatusBar(allTasks.size(), uncompletedTasks.size());
-    } else {
-        QList<Task> categoryTasks = TaskDBManager::getInstance()->getTasksByCategory(category);
-        updateStatusBar(categoryTasks.size(), countUnfinished(categoryTasks));
+void MainWindow::onSearch()
+{
+    m_searchTimer->stop();
+    m_taskModel->setSearchText(m_searchEdit->text());
+}
+
+void MainWindow::onTaskReminder(const QStringList& msgs)
+{
+    // 只入队，合并窗口从第一条开始计时，之后到达的提醒并入同一次展示
+    m_pendingReminders.append(msgs);
+    if (!m_reminderFlushTimer->isActive()) {
+        m_reminderFlushTimer->start();
     }
 }
 
-void MainWindow::onTaskReminder(const QString& msg)
+void MainWindow::flushReminders()
 {
+    if (m_pendingReminders.isEmpty()) return;
+
+    QStringList msgs = m_pendingReminders;
+    m_pendingReminders.clear();
+    qDebug() << "📢 展示合并后的提醒，共" << msgs.size() << "条";
+
     // 1. 托盘图标闪烁（核心：替代气泡通知，更醒目）
     if (m_systemTray && m_systemTray->isVisible()) {
         // 保存原图标
@@ -664,15 +950,38 @@ void MainWindow::onTaskReminder(const QString& msg)
             }
         });
         flashTimer->start(500);
+
+        m_systemTray->showMessage("任务提醒",
+                                  msgs.size() == 1 ? msgs.first() : QString("有 %1 条新的任务提醒").arg(msgs.size()),
+                                  QSystemTrayIcon::Warning, 5000);
+    }
+
+    // 2. 非模态提醒窗口：已打开时追加内容而不是再弹一个，最多列出前20条
+    m_reminderBoxMsgs.append(msgs);
+    const int maxListed = 20;
+    QString text;
+    if (m_reminderBoxMsgs.size() == 1) {
+        text = m_reminderBoxMsgs.first();
+    } else {
+        text = QString("共有 %1 条任务提醒：\n").arg(m_reminderBoxMsgs.size())
+               + m_reminderBoxMsgs.mid(0, maxListed).join("\n");
+        if (m_reminderBoxMsgs.size() > maxListed) {
+            text += QString("\n……另有 %1 条").arg(m_reminderBoxMsgs.size() - maxListed);
+        }
     }
 
-    // 2. 必弹的QMessageBox（确保提醒被看到）
-    QMessageBox msgBox(this);
-    msgBox.setWindowTitle("⚠️ 任务提醒");
-    msgBox.setIcon(QMessageBox::Information);
-    msgBox.setText(msg);
-    msgBox.setWindowFlags(msgBox.windowFlags() | Qt::WindowStaysOnTopHint); // 置顶
-    msgBox.exec();
+    if (!m_reminderBox) {
+        m_reminderBox = new QMessageBox(this);
+        m_reminderBox->setAttribute(Qt::WA_DeleteOnClose);
+        m_reminderBox->setWindowTitle("⚠️ 任务提醒");
+        m_reminderBox->setIcon(QMessageBox::Information);
+        m_reminderBox->setModal(false);
+        m_reminderBox->setWindowFlags(m_reminderBox->windowFlags() | Qt::WindowStaysOnTopHint); // 置顶
+        connect(m_reminderBox.data(), &QObject::destroyed, this, [this]() { m_reminderBoxMsgs.clear(); });
+    }
+    m_reminderBox->setText(text);
+    m_reminderBox->show();
+    m_reminderBox->raise();
 
     // 3. 状态栏永久提示（直到下一次提醒）
     QLabel *reminderLabel = statusBar()->findChild<QLabel*>("reminderStatusLabel");
@@ -682,7 +991,8 @@ void MainWindow::onTaskReminder(const QString& msg)
         reminderLabel->setStyleSheet("color: #E53935; font-weight: bold;");
         statusBar()->insertWidget(1, reminderLabel); // 插入到总任务统计左侧
     }
-    reminderLabel->setText("提醒：" + msg.split("\n").first());
+    reminderLabel->setText(msgs.size() == 1 ? "提醒：" + msgs.first()
+                                            : QString("提醒：%1 等 %2 条").arg(msgs.first()).arg(msgs.size()));
 }
 
 void MainWindow::onSetReminderThreshold()
@@ -4,8 +4,9 @@
 #include "taskdbmanager.h"
 #include "reminderthread.h"
 #include "remindersettingdialog.h"
+#include "tasktablemodel.h"
+#include "refreshscheduler.h"
 #include <QMainWindow>
-#include <QSqlTableModel>
 #include <QTableView>
 #include <QSplitter>
 #include <QListWidget>
@@ -14,8 +15,17 @@
 #include <QLabel>
 #include <QChartView>
 #include <QPieSeries>
+#include <QLineSeries>
+#include <QDateTimeAxis>
+#include <QValueAxis>
+#include <QHash>
 #include <QSystemTrayIcon>
 #include <QMenu>
+#include <QLineEdit>
+#include <QComboBox>
+#include <QTimer>
+#include <QMessageBox>
+#include <QPointer>
 
 #include <windows.h>
 #include <shellapi.h>
@@ -32,15 +42,33 @@ protected:
     void closeEvent(QCloseEvent *event) override;
 
 private:
-    QSqlTableModel *m_taskModel;
+    TaskTableModel *m_taskModel;    // 任务列表模型（列式快照，按更新时间/优先级排序时分页按需加载）
     QListWidget *m_categoryList;    // 左侧分类导航
     QTableView *m_taskTableView;    // 中间任务列表
     QWidget *m_statWidget;          // 右侧统计面板
     QProgressBar *m_completionBar;        // 完成率进度条
-    QLabel *m_totalLabel, *m_unfinishedLabel, *m_rateLabel; // 统计标签
+    QLabel *m_totalLabel, *m_unfinishedLabel, *m_overdueLabel, *m_rateLabel; // 统计标签
     QChartView *m_pieChartView;           // 饼图
+    QPieSeries *m_pieSeries;              // 饼图数据（常驻，原地更新）
+    QHash<QString, QPieSlice*> m_pieSlices; // 分类 → 扇区
+    QComboBox *m_trendRangeBox;           // 趋势范围（按日/按周）
+    QChartView *m_trendChartView;         // 完成趋势折线图
+    QLineSeries *m_createdSeries, *m_completedSeries, *m_overdueSeries; // 趋势折线
+    QDateTimeAxis *m_trendAxisX;
+    QValueAxis *m_trendAxisY;
+    RefreshScheduler *m_refreshScheduler; // 刷新调度器（合并刷新、后台查询）
     ReminderThread *m_reminderThread;
-    QSystemTrayIcon *m_systemTray; // 系统托盘
+    QSystemTrayIcon *m_systemTray = nullptr; // 系统托盘（系统不支持时为空）
+    QLineEdit *m_searchEdit;        // 搜索框
+    QTimer *m_searchTimer;          // 输入防抖定时器
+    QStringList m_pendingReminders;           // 等待合并展示的提醒
+    QTimer *m_reminderFlushTimer = nullptr;   // 提醒合并窗口定时器
+    QPointer<QMessageBox> m_reminderBox;      // 非模态提醒窗口（关闭后自动置空）
+    QStringList m_reminderBoxMsgs;            // 提醒窗口中尚未关闭的提醒
+    int m_nextTaskId = -1;                    // 最近截止任务（-1表示没有）
+    QString m_nextTaskTitle;
+    QDateTime m_nextTaskDeadline;
+    QTimer *m_countdownTimer = nullptr;       // 状态栏倒计时定时器
 
 
 
@@ -53,10 +81,13 @@ private:
     void initReminderThread();            // 提醒线程
 
     void updateStatusBar(int total, int unfinished);
-    int countUnfinished(const QList<Task>& tasks);
-    void refreshStatPanel();
-    void updateLatestTaskStatus();
+    void updateStatPanel();               // 用统计引擎的计数更新统计面板
+    void updateTrendChart(const QList<TaskTrendPoint>& points, const QDate& from, const QDate& to);
+    void applyRefresh(const RefreshResult& result); // 应用刷新调度器的结果
+    void updateLatestTaskStatus();        // 按最近截止任务刷新状态栏倒计时
+    void onNextDeadlineChanged(int taskId, const QString& title, const QDateTime& deadline);
     void initSystemTray(); // 初始化托盘
+    void flushReminders(); // 合并展示排队中的提醒
 
 private slots:
     void onAddTask();
@@ -65,10 +96,12 @@ private slots:
     void onSortByPriority();
     void onRefresh();
     void onAbout();
+    void onImportTasks();
     void onExportExcel();
     void onExportPdf();
     void onCategoryChanged(const QString& category);
-    void onTaskReminder(const QString& msg); // 接收提醒信号的槽函数
+    void onSearch();
+    void onTaskReminder(const QStringList& msgs); // 接收提醒信号的槽函数
     void onSetReminderThreshold(); // 打开阈值设置弹窗
 };
 
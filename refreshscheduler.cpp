@@ -0,0 +1,166 @@
+#include "refreshscheduler.h"
+#include <QtConcurrent>
+
+// 需要在工作线程查询的脏标记
+static const int kQueryFlags = RefreshScheduler::DirtyTrend | RefreshScheduler::DirtyOverdue
+                             | RefreshScheduler::DirtyAggregates;
+
+RefreshScheduler::RefreshScheduler(QObject *parent) : QObject(parent)
+{
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    m_timer->setInterval(kCoalesceMs);
+    connect(m_timer, &QTimer::timeout, this, &RefreshScheduler::startRefresh);
+    connect(&m_watcher, &QFutureWatcher<RefreshResult>::finished, this, &RefreshScheduler::onQueryFinished);
+
+    m_trendTimer = new QTimer(this);
+    m_trendTimer->setSingleShot(true);
+    m_trendTimer->setInterval(kTrendDelayMs);
+    connect(m_trendTimer, &QTimer::timeout, this, [this]() {
+        markDirty(DirtyTrend);
+    });
+
+    m_overdueTimer = new QTimer(this);
+    m_overdueTimer->setSingleShot(true);
+    connect(m_overdueTimer, &QTimer::timeout, this, [this]() {
+        QDateTime until = TaskStatEngine::getInstance()->overdueValidUntil();
+        if (until.isValid() && QDateTime::currentDateTime() >= until) {
+            markDirty(DirtyOverdue);
+        } else {
+            armOverdueTimer();
+        }
+    });
+
+    m_dayTimer = new QTimer(this);
+    m_dayTimer->setSingleShot(true);
+    connect(m_dayTimer, &QTimer::timeout, this, [this]() {
+        markDirty(DirtyTrend);
+        armDayTimer();
+    });
+    armDayTimer();
+
+    // 写操作后计数已由统计引擎增量更新，面板只需重绘；趋势延迟重查
+    // （任务列表逐行更新，最近任务由提醒线程推送）
+    connect(TaskDBManager::getInstance(), &TaskDBManager::tasksChanged, this, [this]() {
+        markDirty(DirtyCounts);
+        if (!m_trendTimer->isActive()) {
+            m_trendTimer->start();
+        }
+    });
+}
+
+RefreshScheduler::~RefreshScheduler()
+{
+    // 等待进行中的查询结束，避免回调到已析构的对象
+    m_watcher.waitForFinished();
+}
+
+void RefreshScheduler::markDirty(int flags)
+{
+    m_dirty |= flags;
+    // 查询进行中时先不启动，结束后再处理新的脏标记
+    if (!m_watcher.isRunning() && !m_timer->isActive()) {
+        m_timer->start();
+    }
+}
+
+void RefreshScheduler::setTrendWeekly(bool weekly)
+{
+    if (m_trendWeekly == weekly) return;
+    m_trendWeekly = weekly;
+    markDirty(DirtyTrend);
+}
+
+void RefreshScheduler::startRefresh()
+{
+    if (m_dirty == 0 || m_watcher.isRunning()) return;
+
+    int flags = m_dirty;
+    m_dirty = 0;
+    quint64 version = TaskDBManager::getInstance()->cacheVersion();
+    if (!(flags & kQueryFlags)) {
+        // 只需重绘，不经过线程池
+        RefreshResult result;
+        result.flags = flags;
+        result.version = version;
+        finishRefresh(result);
+        return;
+    }
+    m_watcher.setFuture(QtConcurrent::run(&RefreshScheduler::runQueries, flags, m_trendWeekly, version));
+}
+
+RefreshResult RefreshScheduler::runQueries(int flags, bool weekly, quint64 version)
+{
+    RefreshResult result;
+    result.flags = flags;
+    result.version = version;
+
+    // 列表在主线程从缓存加载，这里只执行统计查询
+    QSqlDatabase db = TaskDBManager::getInstance()->threadConnection();
+    QDateTime now = QDateTime::currentDateTime();
+    if (flags & DirtyAggregates) {
+        // 聚合结果已包含逾期数
+        result.aggregates = TaskDBManager::getTaskAggregates(db, now);
+    } else if (flags & DirtyOverdue) {
+        result.overdue = TaskDBManager::getOverdueState(db, now);
+    }
+
+    if (flags & DirtyTrend) {
+        result.trendTo = now.date();
+        result.trendFrom = weekly ? result.trendTo.addYears(-1) : result.trendTo.addDays(-29);
+        QList<TaskDailyStat> daily = TaskDBManager::getDailyStats(db, result.trendFrom, result.trendTo);
+        result.trend = TaskStatistic::statTrend(daily, result.trendFrom, result.trendTo,
+                                                weekly ? TrendBucket::Week : TrendBucket::Day);
+    }
+    return result;
+}
+
+void RefreshScheduler::onQueryFinished()
+{
+    finishRefresh(m_watcher.result());
+}
+
+void RefreshScheduler::finishRefresh(RefreshResult result)
+{
+    // 查询失败（错误已记录）时保留面板上的旧数据
+    if ((result.flags & DirtyAggregates) && !result.aggregates.valid) {
+        result.flags &= ~(DirtyAggregates | DirtyOverdue);
+    } else if (!(result.flags & DirtyAggregates) && (result.flags & DirtyOverdue) && !result.overdue.valid) {
+        result.flags &= ~DirtyOverdue;
+    }
+
+    int queried = result.flags & kQueryFlags;
+    if (queried != 0 && result.version != TaskDBManager::getInstance()->cacheVersion()) {
+        // 查询期间又有写入，结果可能不含这些变更，作废后重新排队
+        result.flags &= ~queried;
+        m_dirty |= queried;
+    }
+
+    if (result.flags != 0) {
+        emit refreshReady(result);
+    }
+    // 统计引擎的下一个截止时间可能因本次结果或期间的写入而改变
+    armOverdueTimer();
+    if (m_dirty != 0) {
+        m_timer->start();
+    }
+}
+
+void RefreshScheduler::armOverdueTimer()
+{
+    QDateTime until = TaskStatEngine::getInstance()->overdueValidUntil();
+    if (!until.isValid()) {
+        m_overdueTimer->stop();
+        return;
+    }
+    qint64 ms = QDateTime::currentDateTime().msecsTo(until) + kTimerSlackMs;
+    m_overdueTimer->start(static_cast<int>(qBound<qint64>(0, ms, kMaxTimerMs)));
+}
+
+void RefreshScheduler::armDayTimer()
+{
+    QDateTime now = QDateTime::currentDateTime();
+    // 不超过一天，int毫秒数放得下
+    qint64 ms = now.msecsTo(QDateTime(now.date().addDays(1), QTime(0, 0))) + kTimerSlackMs;
+    m_dayTimer->start(static_cast<int>(qMax<qint64>(0, ms)));
+}
@@ -0,0 +1,67 @@
+#ifndef REFRESHSCHEDULER_H
+#define REFRESHSCHEDULER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QFutureWatcher>
+#include "taskdbmanager.h"
+#include "taskstatistic.h"
+
+// 一次刷新的查询结果，由工作线程生成、主线程一次性应用
+struct RefreshResult {
+    int flags = 0;                    // 本次需要更新的视图（RefreshScheduler::DirtyFlag）
+    quint64 version = 0;              // 查询开始时的任务缓存版本
+    TaskAggregates aggregates;        // 全部计数的聚合（DirtyAggregates）
+    TaskOverdueState overdue;         // 逾期数（DirtyOverdue）
+    QList<TaskTrendPoint> trend;      // 趋势图数据
+    QDate trendFrom, trendTo;
+};
+
+// 刷新调度器：各处只标记哪些视图需要刷新，短时间内的多次请求合并为一次；
+// 统计相关查询在线程池中用线程专用连接执行，结果通过refreshReady一起交给主线程。
+// 写操作后计数由统计引擎增量维护，不再查询；只有随时间变化的逾期数和趋势由定时器触发重查
+class RefreshScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    enum DirtyFlag {
+        DirtyTable = 0x1,             // 任务列表
+        DirtyCounts = 0x2,            // 计数、饼图、状态栏（读统计引擎，不查询）
+        DirtyTrend = 0x4,             // 趋势图
+        DirtyOverdue = 0x8,           // 重查逾期数（有任务到期）
+        DirtyAggregates = 0x10,       // 重新聚合全部计数，重置统计引擎
+        DirtyAll = DirtyTable | DirtyCounts | DirtyTrend | DirtyAggregates
+    };
+
+    explicit RefreshScheduler(QObject *parent = nullptr);
+    ~RefreshScheduler() override;
+
+    void markDirty(int flags);
+    void setTrendWeekly(bool weekly); // 趋势图范围：近一年按周 / 近30天按日
+
+signals:
+    void refreshReady(const RefreshResult& result);
+
+private:
+    void startRefresh();
+    void onQueryFinished();
+    void finishRefresh(RefreshResult result);
+    void armOverdueTimer();
+    void armDayTimer();
+    static RefreshResult runQueries(int flags, bool weekly, quint64 version);
+
+    QTimer *m_timer;                  // 合并窗口
+    QTimer *m_trendTimer;             // 写操作后延迟重查趋势，期间的写入合并为一次
+    QTimer *m_overdueTimer;           // 下一个截止时间到达时重查逾期数
+    QTimer *m_dayTimer;               // 跨天时重查趋势（范围和逾期按日期计算）
+    QFutureWatcher<RefreshResult> m_watcher;
+    int m_dirty = 0;                  // 尚未开始刷新的脏标记
+    bool m_trendWeekly = false;
+
+    static const int kCoalesceMs = 50;
+    static const int kTrendDelayMs = 2000;
+    static const int kTimerSlackMs = 1000;      // 定时器可能提前触发，留出余量
+    static const int kMaxTimerMs = 3600 * 1000; // 更远的到期时间分段等待
+};
+
+#endif // REFRESHSCHEDULER_H
@@ -1,14 +1,27 @@
 #include "ReminderThread.h"
 #include <QDateTime>
 #include <QDebug>
+#include <QSet>
+#include <climits>
 
 ReminderThread::ReminderThread(QObject *parent)
     : QThread(parent), m_reminderThreshold(30) // 默认提前30分钟提醒
 {
-    // 定时器移到子线程（run()中初始化）
-    m_checkTimer = new QTimer();
-    m_checkTimer->setParent(nullptr); // 避免线程销毁时的父子关系问题
-    connect(m_checkTimer, &QTimer::timeout, this, &ReminderThread::checkTasks);
+    // 上下文对象移到本线程：之后投递给它的事件都在提醒线程中执行，
+    // 线程启动前到达的变更会排队，等事件循环开始后再处理，不会丢失
+    m_context = new QObject();
+    m_context->moveToThread(this);
+    connect(TaskDBManager::getInstance(), &TaskDBManager::tasksChanged,
+            m_context, [this](const TaskChangeSet& changes) {
+                onTasksChanged(changes);
+            });
+
+    // 初始任务和已触发记录在主线程读取（数据库连接属于主线程），run()中再入堆
+    m_seedTasks = TaskDBManager::getInstance()->getUncompletedTasks();
+    const QList<QPair<int, int>> firedReminders = TaskDBManager::getInstance()->getFiredReminders();
+    for (const auto& fired : firedReminders) {
+        m_firedKinds[fired.first].append(fired.second);
+    }
 }
 
 ReminderThread::~ReminderThread()
@@ -24,7 +37,9 @@ ReminderThread::~ReminderThread()
         wait();
         qDebug() << "🔹 线程强制终止";
     }
-    // 此时定时器已在run()中释放，无需重复删除
+    // 线程已结束，上下文对象不会再收到事件
+    delete m_context;
+    m_context = nullptr;
 }
 
 // 设置提醒阈值（分钟，确保值为正）
@@ -33,32 +48,36 @@ void ReminderThread::setReminderThreshold(int minutes)
     if (minutes > 0) {
         m_reminderThreshold = minutes;
         qDebug() << "提醒阈值已更新为：" << minutes << "分钟";
+        // 堆中的阈值提醒时刻都要按新阈值重算，交给提醒线程执行
+        QMetaObject::invokeMethod(m_context, [this]() { rescheduleAll(); }, Qt::QueuedConnection);
     }
 }
 
 // 获取当前提醒阈值
 int ReminderThread::getReminderThreshold() const
 {
-    return m_reminderThreshold;
+    return m_reminderThreshold.load();
 }
 
-// 线程入口：启动定时器
+// 线程入口：建堆并启动定时器
 void ReminderThread::run()
 {
     qDebug() << "🔹 线程run()函数开始执行";
 
     // 1. 子线程内创建定时器（关键！避免跨线程定时器问题）
+    //    单次触发+精确定时，间隔由堆顶时刻决定
     m_checkTimer = new QTimer();
-    m_checkTimer->setInterval(10000); // 10秒检测一次（测试用）
+    m_checkTimer->setSingleShot(true);
+    m_checkTimer->setTimerType(Qt::PreciseTimer);
 
     // 2. 子线程内绑定定时器信号（DirectConnection，同线程直接调用）
     connect(m_checkTimer, &QTimer::timeout,
-            this, &ReminderThread::checkTasks,
+            this, &ReminderThread::fireDueReminders,
             Qt::DirectConnection);
 
-    // 3. 启动定时器
-    m_checkTimer->start();
-    qDebug() << "🔹 子线程定时器启动，间隔10秒";
+    // 3. 初始任务入堆并对准第一个到期时刻
+    seedTasks(m_seedTasks);
+    m_seedTasks.clear();
 
     // 4. 启动线程事件循环（必须！否则线程执行完run()就退出）
     exec();
@@ -70,77 +89,237 @@ void ReminderThread::run()
     qDebug() << "🔹 线程run()函数执行完毕";
 }
 
-// 核心：检测即将到期/已逾期任务
-void ReminderThread::checkTasks()
+void ReminderThread::seedTasks(const QList<Task>& tasks)
 {
-    qDebug() << "🔍 开始检测任务（当前阈值：" << m_reminderThreshold << "分钟）";
+    for (const Task& task : tasks) {
+        trackTask(task);
+    }
+    qDebug() << "🔹 提醒调度已建立，跟踪未完成任务数：" << m_tasks.size();
+    armTimer();
+}
 
-    // 数据库连接校验
-    if (!TaskDBManager::getInstance()->isConnected()) {
-        qDebug() << "❌ 数据库连接失败，跳过任务检测";
-        return;
+void ReminderThread::onTasksChanged(const TaskChangeSet& changes)
+{
+    for (const Task& task : changes.added) {
+        if (!task.isCompleted) trackTask(task);
+    }
+
+    for (const auto& change : changes.updated) {
+        const Task& oldTask = change.first;
+        const Task& newTask = change.second;
+        if (newTask.isCompleted) {
+            untrackTask(newTask.id);
+            forgetFired(newTask.id);
+        } else if (oldTask.deadline != newTask.deadline) {
+            // 截止时间变了：提醒重新计算
+            untrackTask(newTask.id);
+            forgetFired(newTask.id);
+            trackTask(newTask);
+        } else if (!m_tasks.contains(newTask.id) || oldTask.reminderOffsets != newTask.reminderOffsets) {
+            // 重新变为未完成，或提前量变了；已触发的提前量仍然有效，不清除
+            untrackTask(newTask.id);
+            trackTask(newTask);
+        } else {
+            // 只改了标题等信息，提醒时刻不变
+            m_tasks[newTask.id] = newTask;
+        }
+    }
+
+    for (const Task& task : changes.removed) {
+        untrackTask(task.id);
+        forgetFired(task.id);
+    }
+
+    armTimer();
+}
+
+void ReminderThread::trackTask(const Task& task)
+{
+    if (task.id < 0 || !task.deadline.isValid()) return;
+
+    // 截止超过补发窗口的任务不再提醒；窗口内未触发过的（如程序关闭期间到期）会补发一次
+    qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    qint64 deadlineMs = task.deadline.toMSecsSinceEpoch();
+    if (deadlineMs <= nowMs - kCatchUpWindowMs) return;
+
+    quint32 generation = ++m_nextGeneration;
+    m_tasks[task.id] = task;
+    m_taskGeneration[task.id] = generation;
+    m_deadlineIndex.insert({deadlineMs, task.id});
+
+    // 提前时刻已过但还未截止的（如新建时离截止不足提前量），入堆后会立即补发
+    for (int minutes : reminderOffsetsOf(task)) {
+        m_heap.push({deadlineMs - qint64(minutes) * 60 * 1000, task.id, minutes, generation});
+    }
+    m_heap.push({deadlineMs, task.id, kDeadlineKind, generation});
+}
+
+QList<int> ReminderThread::reminderOffsetsOf(const Task& task) const
+{
+    // 任务未单独设置时使用全局阈值
+    if (!task.reminderOffsets.isEmpty()) return task.reminderOffsets;
+    return {m_reminderThreshold.load()};
+}
+
+bool ReminderThread::hasFired(int taskId, int kind) const
+{
+    auto it = m_firedKinds.constFind(taskId);
+    return it != m_firedKinds.constEnd() && it->contains(kind);
+}
+
+void ReminderThread::untrackTask(int taskId)
+{
+    // 堆不支持任意删除，移除代号后旧堆项在弹出时被丢弃
+    auto it = m_tasks.constFind(taskId);
+    if (it != m_tasks.constEnd()) {
+        m_deadlineIndex.erase({it->deadline.toMSecsSinceEpoch(), taskId});
+    }
+    m_tasks.remove(taskId);
+    m_taskGeneration.remove(taskId);
+}
+
+void ReminderThread::forgetFired(int taskId)
+{
+    // 与数据库中task_reminder_log的触发器清理保持一致
+    m_firedKinds.remove(taskId);
+}
+
+void ReminderThread::rescheduleAll()
+{
+    rebuildHeap();
+    qDebug() << "🔹 阈值变更，已重建提醒调度（当前阈值：" << m_reminderThreshold.load() << "分钟）";
+    armTimer();
+}
+
+void ReminderThread::rebuildHeap()
+{
+    // 已触发标记不受影响，重建后不会重复提醒
+    QList<Task> tasks = m_tasks.values();
+    m_heap = decltype(m_heap)();
+    m_tasks.clear();
+    m_taskGeneration.clear();
+    m_deadlineIndex.clear();
+    for (const Task& task : tasks) {
+        trackTask(task);
+    }
+}
+
+// 分钟数转为易读的剩余时间
+static QString formatMinutes(qint64 minutes)
+{
+    if (minutes >= 24 * 60) {
+        return QString("%1天%2小时").arg(minutes / (24 * 60)).arg(minutes % (24 * 60) / 60);
+    }
+    if (minutes >= 60) {
+        return QString("%1小时%2分钟").arg(minutes / 60).arg(minutes % 60);
     }
-    QList<Task> allTasks = TaskDBManager::getInstance()->getAllTasks();
-    qDebug() << "查询到的任务总数：" << allTasks.size();
+    return QString("%1分钟").arg(minutes);
+}
 
-    // 初始化变量
+// 核心：弹出所有已到期的提醒时刻
+void ReminderThread::fireDueReminders()
+{
     QDateTime now = QDateTime::currentDateTime();
-    bool taskExpired = false;
+    qint64 nowMs = now.toMSecsSinceEpoch();
     QStringList reminderMsgs;
-    // 用静态Map记录每个任务的提醒状态（避免重复弹窗）
-    static QMap<int, QSet<int>> taskRemindFlag; // key:任务ID，value:已触发的提醒类型（1=阈值提醒，2=截止提醒）
-
-    for (const Task& task : allTasks) {
-        // 跳过已完成任务，重置提醒标记
-        if (task.isCompleted) {
-            qDebug() << "跳过已完成任务：" << task.title;
-            taskRemindFlag.remove(task.id);
-            continue;
-        }
+    QList<QPair<int, int>> firedReminders;
+    QSet<int> remindedTasks;    // 本轮已发过提前提醒的任务（补发时多个提前量同时到期只提示一次）
 
-        // 计算剩余时间（秒转分钟）
-        qint64 diffSeconds = now.secsTo(task.deadline);
-        qint64 diffMinutes = diffSeconds / 60;
-        qDebug() << "任务：" << task.title
-                 << " | 截止时间：" << task.deadline.toString("yyyy-MM-dd HH:mm:ss")
-                 << " | 当前时间：" << now.toString("yyyy-MM-dd HH:mm:ss")
-                 << " | 剩余分钟：" << diffMinutes;
-
-        // 逾期任务：重置标记+标记状态
-        if (diffMinutes < 0) {
-            taskExpired = true;
-            taskRemindFlag.remove(task.id); // 逾期后重置提醒标记
-            qDebug() << "⚠️ 任务「" << task.title << "」已逾期 " << -diffMinutes << " 分钟";
-            continue;
-        }
+    while (!m_heap.empty() && m_heap.top().dueMs <= nowMs) {
+        ReminderEntry entry = m_heap.top();
+        m_heap.pop();
 
-        // ===== 核心逻辑：仅阈值时间、截止时间弹窗（各一次）=====
-        // 1. 阈值时间提醒
-        if (diffMinutes == m_reminderThreshold && !taskRemindFlag[task.id].contains(1)) {
-            reminderMsgs.append(QString("【提醒】任务「%1」将在 %2 分钟后截止！").arg(task.title).arg(diffMinutes));
-            taskRemindFlag[task.id].insert(1); // 标记已触发阈值提醒
-            qDebug() << "🚨 触发阈值提醒：" << task.title;
+        // 任务已完成/删除/改期，堆项失效
+        if (m_taskGeneration.value(entry.taskId) != entry.generation) continue;
+        if (hasFired(entry.taskId, entry.kind)) {
+            if (entry.kind == kDeadlineKind) untrackTask(entry.taskId);
+            continue;
         }
 
-        // 2. 截止时间提醒
-        if (diffMinutes == 0 && !taskRemindFlag[task.id].contains(2)) {
+        const Task task = m_tasks.value(entry.taskId);
+        if (entry.kind != kDeadlineKind) {
+            // 截止提醒会紧接着触发的情况下不再发提前提醒
+            qint64 diffMinutes = now.secsTo(task.deadline) / 60;
+            if (diffMinutes <= 0) continue;
+            if (!remindedTasks.contains(entry.taskId)) {
+                remindedTasks.insert(entry.taskId);
+                reminderMsgs.append(QString("【提醒】任务「%1」将在 %2 后截止！").arg(task.title, formatMinutes(diffMinutes)));
+                qDebug() << "🚨 触发提前提醒：" << task.title << "（提前" << entry.kind << "分钟）";
+            }
+        } else {
             reminderMsgs.append(QString("【提醒】任务「%1」已到截止时间！").arg(task.title));
-            taskRemindFlag[task.id].insert(2); // 标记已触发截止提醒
             qDebug() << "🚨 触发截止提醒：" << task.title;
+            // 截止后不再需要跟踪
+            untrackTask(entry.taskId);
         }
+        m_firedKinds[entry.taskId].append(entry.kind);
+        firedReminders.append(qMakePair(entry.taskId, entry.kind));
+    }
+
+    // 触发记录交给主线程落库（数据库连接属于主线程）
+    if (!firedReminders.isEmpty()) {
+        QMetaObject::invokeMethod(TaskDBManager::getInstance(), [firedReminders]() {
+            TaskDBManager::getInstance()->markRemindersFired(firedReminders);
+        }, Qt::QueuedConnection);
     }
 
-    // 发射提醒信号
+    // 发射提醒信号（一轮只发一次，条数再多也由界面汇总）
     if (!reminderMsgs.isEmpty()) {
-        qDebug() << "📢 发射提醒信号：" << reminderMsgs.join("\n");
-        emit reminder(reminderMsgs.join("\n"));
-        emit taskStatusChanged(); // 更新状态栏
-    } else {
-        qDebug() << "ℹ️ 无待提醒任务（未到阈值/截止时间）";
+        qDebug() << "📢 发射提醒信号，共" << reminderMsgs.size() << "条";
+        emit reminder(reminderMsgs);
+    }
+
+    armTimer();
+}
+
+void ReminderThread::armTimer()
+{
+    if (!m_checkTimer) return;  // run()之前的变更在建堆时一并处理
+
+    // 丢弃堆顶的失效项；失效项过多时整体重建，防止堆无限增长
+    while (!m_heap.empty() && m_taskGeneration.value(m_heap.top().taskId) != m_heap.top().generation) {
+        m_heap.pop();
+    }
+    // 每个任务有(提前量个数+1)个堆项，超过这个量级的部分基本都是失效项
+    if (m_heap.size() > size_t(m_tasks.size()) * 16 + 64) {
+        rebuildHeap();
+    }
+
+    // 每次调度变化都会走到这里，顺便检查最近截止任务
+    publishNextDeadline();
+
+    if (m_heap.empty()) {
+        m_checkTimer->stop();
+        return;
     }
 
-    // 有逾期任务时更新状态栏
-    if (taskExpired) {
-        emit taskStatusChanged();
+    // 最长睡1小时再校准一次，防止系统休眠/改时间造成偏差
+    qint64 waitMs = m_heap.top().dueMs - QDateTime::currentMSecsSinceEpoch();
+    waitMs = qBound<qint64>(0, waitMs, 60 * 60 * 1000);
+    m_checkTimer->start(int(waitMs));
+}
+
+void ReminderThread::publishNextDeadline()
+{
+    // 已截止但还在补发窗口内的任务排在前面，跳过它们
+    qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    auto it = m_deadlineIndex.upper_bound({nowMs, INT_MAX});
+
+    int taskId = -1;
+    qint64 deadlineMs = 0;
+    QString title;
+    if (it != m_deadlineIndex.end()) {
+        deadlineMs = it->first;
+        taskId = it->second;
+        title = m_tasks.value(taskId).title;
     }
+
+    if (taskId == m_publishedTaskId && deadlineMs == m_publishedDeadlineMs && title == m_publishedTitle) return;
+    m_publishedTaskId = taskId;
+    m_publishedDeadlineMs = deadlineMs;
+    m_publishedTitle = title;
+
+    // 截止时刻本身就是堆项，到点时定时器会唤醒并切换到下一个任务
+    QDateTime deadline = (taskId == -1) ? QDateTime() : QDateTime::fromMSecsSinceEpoch(deadlineMs);
+    emit nextDeadlineChanged(taskId, title, deadline);
 }
@@ -4,9 +4,19 @@
 #include <QThread>
 #include <QTimer>
 #include <QList>
+#include <QHash>
+#include <QStringList>
+#include <QVarLengthArray>
+#include <atomic>
+#include <functional>
+#include <queue>
+#include <set>
+#include <utility>
+#include <vector>
 #include "taskdbmanager.h"
 
-// 任务提醒线程：异步检测即将到期/逾期任务并弹出提醒
+// 任务提醒线程：维护未完成任务的提醒时刻小顶堆，定时器只在下一个到期时刻唤醒，
+// 任务增删改通过TaskDBManager::tasksChanged增量更新，不再轮询数据库
 class ReminderThread : public QThread
 {
     Q_OBJECT
@@ -23,17 +33,55 @@ protected:
     void run() override; // 线程入口函数
 
 signals:
-    // 检测到待提醒任务时触发（传递提醒文本）
-    void reminder(const QString& msg);
-    void taskStatusChanged();
-
-private slots:
-    // 定时检测任务
-    void checkTasks();
+    // 一轮检测中到期的全部提醒（每条一行文本），由界面合并展示
+    void reminder(const QStringList& msgs);
+    // 最近一个尚未截止的任务变化（taskId为-1表示没有），界面据此倒计时，无需查询数据库
+    void nextDeadlineChanged(int taskId, const QString& title, const QDateTime& deadline);
 
 private:
-    QTimer *m_checkTimer = nullptr;       // 定时检测定时器
-    int m_reminderThreshold;    // 提醒阈值（分钟，默认30）
+    // 提醒类型：0为截止时刻提醒，大于0为截止前提前的分钟数
+    static const int kDeadlineKind = 0;
+
+    // 堆中的一个提醒时刻
+    struct ReminderEntry {
+        qint64 dueMs;           // 触发时刻（msecsSinceEpoch）
+        int taskId;
+        int kind;               // 提醒类型（见kDeadlineKind）
+        quint32 generation;     // 入堆时任务的代号，与m_taskGeneration不一致即已失效
+        bool operator>(const ReminderEntry& other) const { return dueMs > other.dueMs; }
+    };
+
+    // 以下成员只在提醒线程内访问
+    void seedTasks(const QList<Task>& tasks);
+    void onTasksChanged(const TaskChangeSet& changes);
+    void trackTask(const Task& task);      // 记录任务并压入其提醒时刻
+    void untrackTask(int taskId);          // 停止跟踪，旧的堆项随之失效
+    void forgetFired(int taskId);          // 任务完成/删除/改期，清除已触发标记
+    bool hasFired(int taskId, int kind) const;
+    QList<int> reminderOffsetsOf(const Task& task) const;  // 任务实际生效的提前量
+    void rescheduleAll();                  // 阈值变化后重建整个堆
+    void rebuildHeap();                    // 按当前跟踪的任务重新生成堆项
+    void fireDueReminders();               // 弹出所有已到期的提醒
+    void armTimer();                       // 把定时器对准堆顶时刻
+    void publishNextDeadline();            // 最近截止任务有变化时通知界面
+
+    static const qint64 kCatchUpWindowMs = 24 * 60 * 60 * 1000;  // 到期提醒的补发窗口（24小时）
+
+    QTimer *m_checkTimer = nullptr;        // 单次定时器，只在下一个到期时刻触发
+    QObject *m_context = nullptr;          // 属于提醒线程的上下文对象，跨线程事件投递到它
+    std::atomic<int> m_reminderThreshold;  // 提醒阈值（分钟，默认30）
+
+    std::priority_queue<ReminderEntry, std::vector<ReminderEntry>, std::greater<ReminderEntry>> m_heap;
+    QHash<int, Task> m_tasks;              // 正在跟踪的未完成任务
+    QHash<int, quint32> m_taskGeneration;  // 任务当前代号
+    std::set<std::pair<qint64, int>> m_deadlineIndex;  // 跟踪任务按(截止时刻, id)排序，取最近截止任务
+    int m_publishedTaskId = -1;            // 上次通知界面的最近截止任务
+    qint64 m_publishedDeadlineMs = 0;
+    QString m_publishedTitle;
+    // 已触发的提醒类型，task_reminder_log表的内存镜像；每任务通常只有几项，不额外分配堆内存
+    QHash<int, QVarLengthArray<int, 4>> m_firedKinds;
+    quint32 m_nextGeneration = 0;
+    QList<Task> m_seedTasks;               // 构造时取得的初始任务，run()中入堆
 };
 
 #endif
@@ -1,16 +1,63 @@
 #include "TaskDBManager.h"
 #include <QCoreApplication>
+#include <QRegularExpression>
+#include <QMutexLocker>
+#include <QSet>
+#include <QThread>
+#include <QThreadStorage>
+#include <algorithm>
+#include <functional>
 
 // 静态单例初始化
 TaskDBManager* TaskDBManager::m_instance = nullptr;
 
+// 各查询方法的SQL，启动时的执行计划自检也使用同一份
+static const char *kSqlUncompletedTasks =
+    "SELECT * FROM tasks WHERE is_completed = 0 ORDER BY deadline ASC";
+static const char *kSqlTasksByCategory =
+    "SELECT * FROM tasks WHERE category = :category ORDER BY priority DESC";
+static const char *kSqlLatestTask =
+    "SELECT * FROM tasks WHERE is_completed = 0 AND deadline > :now ORDER BY deadline ASC LIMIT 1";
+static const char *kSqlTaskAggregates =
+    "SELECT category, priority, COUNT(*), SUM(is_completed), "
+    "SUM(is_completed = 0 AND deadline < :now), "
+    "MIN(CASE WHEN is_completed = 0 AND deadline >= :nowNext THEN deadline END) "
+    "FROM tasks GROUP BY category, priority";
+static const char *kSqlOverdueState =
+    "SELECT (SELECT COUNT(*) FROM tasks WHERE is_completed = 0 AND deadline < :now), "
+    "(SELECT MIN(deadline) FROM tasks WHERE is_completed = 0 AND deadline >= :nowNext)";
+
+// 键集分页SQL：按(排序列, id)整体升序或降序，从上一页最后一条之后继续取，不使用OFFSET
+static QString pageSql(TaskSortKey sortKey, bool ascending, bool hasCategory, bool hasCursor)
+{
+    QString sortColumn = (sortKey == TaskSortKey::Priority) ? "priority" : "update_time";
+    QString direction = ascending ? "ASC" : "DESC";
+    QStringList conditions;
+    if (hasCategory) {
+        conditions << "category = :category";
+    }
+    if (hasCursor) {
+        conditions << QString("(%1, id) %2 (:afterKey, :afterId)").arg(sortColumn, ascending ? ">" : "<");
+    }
+
+    QString sql = "SELECT * FROM tasks";
+    if (!conditions.isEmpty()) {
+        sql += " WHERE " + conditions.join(" AND ");
+    }
+    sql += QString(" ORDER BY %1 %2, id %2 LIMIT :limit").arg(sortColumn, direction);
+    return sql;
+}
+
 TaskDBManager::TaskDBManager(QObject *parent) : QObject(parent)
 {
+    // 变更集合需要跨线程排队传递
+    qRegisterMetaType<TaskChangeSet>("TaskChangeSet");
+
     //设置数据库路径
     m_db = QSqlDatabase::addDatabase("QSQLITE");
-    QString dbPath = "E:/qt_test/QtFinal/QtFinal.db";
-    m_db.setDatabaseName(dbPath);
-    qDebug() << "程序实际连接的数据库路径：" << dbPath;
+    m_dbPath = "E:/qt_test/QtFinal/QtFinal.db";
+    m_db.setDatabaseName(m_dbPath);
+    qDebug() << "程序实际连接的数据库路径：" << m_dbPath;
 
     // 打开数据库
     if (!m_db.open()) {
@@ -24,7 +71,11 @@ TaskDBManager::TaskDBManager(QObject *parent) : QObject(parent)
     // 初始化表结构
     if (!initTables()) {
         qCritical() << "表初始化失败！";
+        return;
     }
+
+    // 自检：确认主要查询都能走索引
+    checkQueryPlans();
 }
 
 TaskDBManager::~TaskDBManager()
@@ -60,60 +111,364 @@ bool TaskDBManager::isTableExists(const QString& tableName)
     return query.next();
 }
 
+bool TaskDBManager::isColumnExists(const QString& tableName, const QString& columnName)
+{
+    QSqlQuery query(m_db);
+    if (!query.exec(QString("PRAGMA table_info(%1)").arg(tableName))) {
+        qCritical() << "读取表结构失败：" << query.lastError().text();
+        return false;
+    }
+    while (query.next()) {
+        if (query.value("name").toString() == columnName) return true;
+    }
+    return false;
+}
+
 bool TaskDBManager::initTables()
 {
-    // 先检查 tasks 表是否存在
+    QSqlQuery query(m_db);
+
+    // 先检查 tasks 表是否存在，不存在才建表
     if (isTableExists("tasks")) {
         qDebug() << "tasks 表已存在，无需初始化";
-        return true;
-    }
 
-    // 表不存在 → 执行建表+建索引
-    QSqlQuery query(m_db);
+        // 旧数据库升级：补充每任务提醒提前量列
+        if (!isColumnExists("tasks", "reminder_offsets")) {
+            if (!query.exec("ALTER TABLE tasks ADD COLUMN reminder_offsets TEXT NOT NULL DEFAULT '';")) {
+                qCritical() << "添加reminder_offsets列失败：" << query.lastError().text();
+                return false;
+            }
+            qDebug() << "tasks 表已添加 reminder_offsets 列";
+        }
 
-    // 1. 创建任务表
-    QString createTableSql = R"(
-        CREATE TABLE tasks (
-            id INTEGER PRIMARY KEY AUTOINCREMENT,
-            title TEXT NOT NULL,
-            category TEXT NOT NULL DEFAULT '未分类',
-            priority INTEGER NOT NULL DEFAULT 3,
-            deadline TEXT NOT NULL,
-            is_completed INTEGER NOT NULL DEFAULT 0,
-            description TEXT,
-            create_time TEXT NOT NULL,
-            update_time TEXT NOT NULL
-        );
-    )";
-    if (!query.exec(createTableSql)) {
-        qCritical() << "建表失败：" << query.lastError().text();
-        return false;
+        // 旧数据库升级：补充完成时间列，已完成任务没有记录，按最后更新时间估计
+        if (!isColumnExists("tasks", "completed_at")) {
+            if (!query.exec("ALTER TABLE tasks ADD COLUMN completed_at TEXT;")
+                || !query.exec("UPDATE tasks SET completed_at = update_time WHERE is_completed = 1;")) {
+                qCritical() << "添加completed_at列失败：" << query.lastError().text();
+                return false;
+            }
+            qDebug() << "tasks 表已添加 completed_at 列";
+        }
+    } else {
+        // 1. 创建任务表
+        QString createTableSql = R"(
+            CREATE TABLE tasks (
+                id INTEGER PRIMARY KEY AUTOINCREMENT,
+                title TEXT NOT NULL,
+                category TEXT NOT NULL DEFAULT '未分类',
+                priority INTEGER NOT NULL DEFAULT 3,
+                deadline TEXT NOT NULL,
+                is_completed INTEGER NOT NULL DEFAULT 0,
+                description TEXT,
+                create_time TEXT NOT NULL,
+                update_time TEXT NOT NULL,
+                reminder_offsets TEXT NOT NULL DEFAULT '',
+                completed_at TEXT
+            );
+        )";
+        if (!query.exec(createTableSql)) {
+            qCritical() << "建表失败：" << query.lastError().text();
+            return false;
+        }
+        qDebug() << "tasks 表创建成功";
     }
-    qDebug() << "tasks 表创建成功";
 
-    // 2. 创建索引（索引也可检查存在性，可选）
+    // 2. 创建索引（IF NOT EXISTS，旧数据库升级时也会补齐新增的索引）
+    //    主键id即rowid，单列索引天然以(列, id)排序，可直接用于键集分页
     QStringList indexSqls = {
-        "CREATE INDEX idx_tasks_category ON tasks(category);",
-        "CREATE INDEX idx_tasks_priority ON tasks(priority);",
-        "CREATE INDEX idx_tasks_completed ON tasks(is_completed);",
-        "CREATE INDEX idx_tasks_deadline ON tasks(deadline);"
+        // 未完成任务按截止时间：getUncompletedTasks / getLatestTask
+        "CREATE INDEX IF NOT EXISTS idx_tasks_open_deadline ON tasks(deadline) WHERE is_completed = 0;",
+        // 分类筛选+排序：getTasksByCategory / 分页；分组聚合：getTaskAggregates
+        "CREATE INDEX IF NOT EXISTS idx_tasks_category_priority ON tasks(category, priority);",
+        "CREATE INDEX IF NOT EXISTS idx_tasks_category_update ON tasks(category, update_time);",
+        // 全部任务分页
+        "CREATE INDEX IF NOT EXISTS idx_tasks_priority ON tasks(priority);",
+        "CREATE INDEX IF NOT EXISTS idx_tasks_update_time ON tasks(update_time);"
     };
     for (const QString& sql : indexSqls) {
         if (!query.exec(sql)) {
             qDebug() << "索引创建失败：" << query.lastError().text();
         } else {
-            qDebug() << "索引创建成功：" << sql.split(" ")[3];
+            qDebug() << "索引已就绪：" << sql.split(" ")[5];
         }
     }
 
+    // 旧版本的单列索引已被上面的复合/部分索引覆盖，只会拖慢写入
+    QStringList obsoleteIndexes = {"idx_tasks_category", "idx_tasks_completed", "idx_tasks_deadline"};
+    for (const QString& name : obsoleteIndexes) {
+        if (!query.exec(QString("DROP INDEX IF EXISTS %1;").arg(name))) {
+            qDebug() << "旧索引删除失败：" << query.lastError().text();
+        }
+    }
+
+    // 3. 全文检索失败不影响基本功能，搜索会退化为LIKE匹配
+    if (!initFullTextSearch()) {
+        qWarning() << "全文检索初始化失败，搜索将使用LIKE匹配";
+    }
+
+    // 4. 提醒记录表
+    if (!initReminderLog()) {
+        qWarning() << "提醒记录表初始化失败，重启后可能重复提醒";
+    }
+
+    // 5. 按日预聚合统计表
+    if (!initDailyStats()) {
+        qWarning() << "按日统计表初始化失败，趋势图将无数据";
+    }
+
     return true;
 }
 
+// 把一行任务(new/old)计入(+1)或移出(-1)task_daily_stats：
+// 创建日计created，完成日(completed_at)计completed，截止日计due_total/due_open
+static QString dailyStatsUpsert(const QString& row, int sign)
+{
+    return QString(R"(
+               INSERT INTO task_daily_stats (day, created, completed, due_total, due_open)
+               SELECT * FROM (VALUES
+                   (date(%1.create_time), %2, 0, 0, 0),
+                   (date(%1.completed_at), 0, %2, 0, 0),
+                   (date(%1.deadline), 0, 0, %2, %2 * (%1.is_completed = 0)))
+               WHERE column1 IS NOT NULL
+               ON CONFLICT(day) DO UPDATE SET
+                   created = created + excluded.created,
+                   completed = completed + excluded.completed,
+                   due_total = due_total + excluded.due_total,
+                   due_open = due_open + excluded.due_open;)").arg(row).arg(sign);
+}
+
+bool TaskDBManager::initDailyStats()
+{
+    QSqlQuery query(m_db);
+    bool needBackfill = !isTableExists("task_daily_stats");
+
+    // 旧版本按update_time计完成日，任务完成后的任何编辑都会把完成数挪到编辑当天；
+    // 发现旧触发器时删掉重建，并按completed_at重新回填
+    query.exec("SELECT sql FROM sqlite_master WHERE type = 'trigger' AND name = 'task_daily_stats_au'");
+    if (query.next() && !query.value(0).toString().contains("completed_at")) {
+        const QStringList rebuildSqls = {
+            "DROP TRIGGER IF EXISTS task_daily_stats_ai;",
+            "DROP TRIGGER IF EXISTS task_daily_stats_ad;",
+            "DROP TRIGGER IF EXISTS task_daily_stats_au;",
+            "DELETE FROM task_daily_stats;"
+        };
+        for (const QString& sql : rebuildSqls) {
+            if (!query.exec(sql)) {
+                qWarning() << "按日统计表升级失败：" << query.lastError().text();
+                return false;
+            }
+        }
+        needBackfill = true;
+        qDebug() << "按日统计改为按完成时间计数，重新回填";
+    }
+
+    // 每天一行，趋势图按日期范围读取几百行即可，不扫描任务历史
+    // 完成日取completed_at：只在完成状态变化时写入，之后编辑任务不会改变
+    QStringList sqls = {
+        R"(CREATE TABLE IF NOT EXISTS task_daily_stats (
+               day TEXT PRIMARY KEY,
+               created INTEGER NOT NULL DEFAULT 0,
+               completed INTEGER NOT NULL DEFAULT 0,
+               due_total INTEGER NOT NULL DEFAULT 0,
+               due_open INTEGER NOT NULL DEFAULT 0
+           ) WITHOUT ROWID;)",
+        QString("CREATE TRIGGER IF NOT EXISTS task_daily_stats_ai AFTER INSERT ON tasks BEGIN %1 END;")
+            .arg(dailyStatsUpsert("new", 1)),
+        QString("CREATE TRIGGER IF NOT EXISTS task_daily_stats_ad AFTER DELETE ON tasks BEGIN %1 END;")
+            .arg(dailyStatsUpsert("old", -1)),
+        // 先移出旧行再计入新行，完成状态、截止时间的变化都能正确反映；完成后的普通编辑不改completed_at，完成数不动
+        QString("CREATE TRIGGER IF NOT EXISTS task_daily_stats_au AFTER UPDATE ON tasks BEGIN %1 %2 END;")
+            .arg(dailyStatsUpsert("old", -1), dailyStatsUpsert("new", 1))
+    };
+    for (const QString& sql : sqls) {
+        if (!query.exec(sql)) {
+            qWarning() << "按日统计表创建失败：" << query.lastError().text();
+            return false;
+        }
+    }
+
+    // 首次建表时用已有任务回填一次，之后只靠触发器维护
+    if (needBackfill) {
+        QString backfillSql = R"(
+            INSERT INTO task_daily_stats (day, created, completed, due_total, due_open)
+            SELECT day, SUM(created), SUM(completed), SUM(due_total), SUM(due_open) FROM (
+                SELECT date(create_time) AS day, 1 AS created, 0 AS completed, 0 AS due_total, 0 AS due_open FROM tasks
+                UNION ALL SELECT date(completed_at), 0, 1, 0, 0 FROM tasks WHERE completed_at IS NOT NULL
+                UNION ALL SELECT date(deadline), 0, 0, 1, is_completed = 0 FROM tasks
+            ) WHERE day IS NOT NULL GROUP BY day;
+        )";
+        if (!query.exec(backfillSql)) {
+            qWarning() << "按日统计回填失败：" << query.lastError().text();
+            return false;
+        }
+        qDebug() << "按日统计表回填完成，共" << query.numRowsAffected() << "天";
+    }
+    return true;
+}
+
+bool TaskDBManager::initReminderLog()
+{
+    QSqlQuery query(m_db);
+
+    // 每个任务每种提醒一行，主键即索引，WITHOUT ROWID省去额外的rowid存储
+    QStringList sqls = {
+        R"(CREATE TABLE IF NOT EXISTS task_reminder_log (
+               task_id INTEGER NOT NULL,
+               kind INTEGER NOT NULL,
+               fired_at TEXT NOT NULL,
+               PRIMARY KEY (task_id, kind)
+           ) WITHOUT ROWID;)",
+        // 任务删除、完成或改期后，旧的提醒记录不再有意义
+        R"(CREATE TRIGGER IF NOT EXISTS task_reminder_log_ad AFTER DELETE ON tasks BEGIN
+               DELETE FROM task_reminder_log WHERE task_id = old.id;
+           END;)",
+        R"(CREATE TRIGGER IF NOT EXISTS task_reminder_log_au AFTER UPDATE OF is_completed, deadline ON tasks
+           WHEN new.is_completed = 1 OR new.deadline <> old.deadline BEGIN
+               DELETE FROM task_reminder_log WHERE task_id = old.id;
+           END;)"
+    };
+    for (const QString& sql : sqls) {
+        if (!query.exec(sql)) {
+            qWarning() << "提醒记录表创建失败：" << query.lastError().text();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TaskDBManager::initFullTextSearch()
+{
+    QSqlQuery query(m_db);
+
+    if (!isTableExists("tasks_fts")) {
+        // 外部内容表：只存倒排索引，正文仍在tasks中
+        // 优先trigram分词（SQLite 3.34+），中文没有空格分词，按三字组才能检索子串
+        QString createSql = R"(
+            CREATE VIRTUAL TABLE tasks_fts USING fts5(
+                title, description,
+                content='tasks', content_rowid='id', tokenize='%1'
+            );
+        )";
+        if (!query.exec(createSql.arg("trigram"))
+            && !query.exec(createSql.arg("unicode61"))) {
+            qWarning() << "创建全文检索表失败：" << query.lastError().text();
+            return false;
+        }
+
+        // 为已有数据建立索引；标题权重高于描述
+        if (!query.exec("INSERT INTO tasks_fts(tasks_fts) VALUES('rebuild');")
+            || !query.exec("INSERT INTO tasks_fts(tasks_fts, rank) VALUES('rank', 'bm25(10.0, 1.0)');")) {
+            qWarning() << "建立全文检索索引失败：" << query.lastError().text();
+            return false;
+        }
+        qDebug() << "tasks_fts 全文检索表创建成功";
+    }
+
+    // 触发器保持索引与tasks同步
+    QStringList triggerSqls = {
+        R"(CREATE TRIGGER IF NOT EXISTS tasks_fts_ai AFTER INSERT ON tasks BEGIN
+               INSERT INTO tasks_fts(rowid, title, description) VALUES (new.id, new.title, new.description);
+           END;)",
+        R"(CREATE TRIGGER IF NOT EXISTS tasks_fts_ad AFTER DELETE ON tasks BEGIN
+               INSERT INTO tasks_fts(tasks_fts, rowid, title, description) VALUES ('delete', old.id, old.title, old.description);
+           END;)",
+        R"(CREATE TRIGGER IF NOT EXISTS tasks_fts_au AFTER UPDATE OF title, description ON tasks BEGIN
+               INSERT INTO tasks_fts(tasks_fts, rowid, title, description) VALUES ('delete', old.id, old.title, old.description);
+               INSERT INTO tasks_fts(rowid, title, description) VALUES (new.id, new.title, new.description);
+           END;)"
+    };
+    for (const QString& sql : triggerSqls) {
+        if (!query.exec(sql)) {
+            qWarning() << "全文检索触发器创建失败：" << query.lastError().text();
+            return false;
+        }
+    }
+
+    // 记录实际使用的分词器，决定查询语法
+    query.exec("SELECT sql FROM sqlite_master WHERE name = 'tasks_fts'");
+    m_ftsTrigram = query.next() && query.value(0).toString().contains("trigram");
+    m_ftsAvailable = true;
+    return true;
+}
+
+void TaskDBManager::checkQueryPlans()
+{
+    // 每个查询形状配一组示例参数，只看计划不执行
+    struct PlanCheck {
+        QString name;
+        QString sql;
+        QVariantMap binds;
+    };
+    QVariantMap categoryBind{{":category", "工作"}};
+    QVariantMap cursorBind{{":afterKey", 3}, {":afterId", 1}, {":limit", 200}};
+    QVariantMap categoryCursorBind = cursorBind;
+    categoryCursorBind.insert(":category", "工作");
+
+    QList<PlanCheck> checks = {
+        {"getUncompletedTasks", kSqlUncompletedTasks, {}},
+        {"getTasksByCategory", kSqlTasksByCategory, categoryBind},
+        {"getLatestTask", kSqlLatestTask, {{":now", "2026-01-01 00:00:00"}}},
+        {"getTaskAggregates", kSqlTaskAggregates, {{":now", "2026-01-01 00:00:00"}, {":nowNext", "2026-01-01 00:00:00"}}},
+        {"getOverdueState", kSqlOverdueState, {{":now", "2026-01-01 00:00:00"}, {":nowNext", "2026-01-01 00:00:00"}}},
+        {"getTasksPage(更新时间)", pageSql(TaskSortKey::UpdateTime, false, false, true), cursorBind},
+        {"getTasksPage(优先级)", pageSql(TaskSortKey::Priority, false, false, true), cursorBind},
+        {"getTasksPage(优先级升序)", pageSql(TaskSortKey::Priority, true, false, true), cursorBind},
+        {"getTasksPage(分类+更新时间)", pageSql(TaskSortKey::UpdateTime, false, true, true), categoryCursorBind},
+        {"getTasksPage(分类+优先级)", pageSql(TaskSortKey::Priority, false, true, true), categoryCursorBind}
+    };
+
+    int problems = 0;
+    for (const PlanCheck& check : checks) {
+        QSqlQuery query(m_db);
+        query.prepare("EXPLAIN QUERY PLAN " + check.sql);
+        for (auto it = check.binds.cbegin(); it != check.binds.cend(); ++it) {
+            query.bindValue(it.key(), it.value());
+        }
+        if (!query.exec()) {
+            qWarning() << "执行计划自检失败：" << check.name << query.lastError().text();
+            continue;
+        }
+
+        // detail列形如"SEARCH tasks USING INDEX ..."；不带索引的SCAN即全表扫描，TEMP B-TREE为额外排序
+        // SQLite 3.36之前写作"SCAN TABLE tasks"/"SEARCH TABLE tasks"，两种写法都要识别
+        while (query.next()) {
+            QString detail = query.value(3).toString();
+            bool fullScan = (detail.startsWith("SCAN tasks") || detail.startsWith("SCAN TABLE tasks"))
+                            && !detail.contains("INDEX");
+            if (fullScan || detail.contains("TEMP B-TREE")) {
+                qWarning() << "⚠️ 查询未充分利用索引：" << check.name << "→" << detail;
+                problems++;
+            }
+        }
+    }
+
+    if (problems == 0) {
+        qDebug() << "执行计划自检通过，" << checks.size() << "个查询均使用索引";
+    }
+}
+
 bool TaskDBManager::isConnected() const
 {
     return m_db.isOpen();
 }
 
+Task TaskDBManager::taskFromQuery(const QSqlQuery& query)
+{
+    QVariantMap map;
+    map["id"] = query.value("id");
+    map["title"] = query.value("title");
+    map["category"] = query.value("category");
+    map["priority"] = query.value("priority");
+    map["deadline"] = query.value("deadline");
+    map["is_completed"] = query.value("is_completed");
+    map["description"] = query.value("description");
+    map["create_time"] = query.value("create_time");
+    map["update_time"] = query.value("update_time");
+    map["reminder_offsets"] = query.value("reminder_offsets");
+    return Task::fromMap(map);
+}
+
 bool TaskDBManager::addTask(Task& task)
 {
     if (!isConnected()) return false;
@@ -123,8 +478,8 @@ bool TaskDBManager::addTask(Task& task)
 
     QSqlQuery query(m_db);
     query.prepare(R"(
-        INSERT INTO tasks (title, category, priority, deadline, is_completed, description, create_time, update_time)
-        VALUES (:title, :category, :priority, :deadline, :is_completed, :description, :create_time, :update_time)
+        INSERT INTO tasks (title, category, priority, deadline, is_completed, description, create_time, update_time, reminder_offsets, completed_at)
+        VALUES (:title, :category, :priority, :deadline, :is_completed, :description, :create_time, :update_time, :reminder_offsets, :completed_at)
     )");
 
     QVariantMap taskMap = task.toMap();
@@ -136,6 +491,9 @@ bool TaskDBManager::addTask(Task& task)
     query.bindValue(":description", taskMap["description"]);
     query.bindValue(":create_time", taskMap["create_time"]);
     query.bindValue(":update_time", taskMap["update_time"]);
+    query.bindValue(":reminder_offsets", taskMap["reminder_offsets"]);
+    // 新建即完成的任务，完成时间取创建时间
+    query.bindValue(":completed_at", task.isCompleted ? taskMap["create_time"] : QVariant());
 
     if (!query.exec()) {
         qCritical() << "新增任务失败：" << query.lastError().text();
@@ -144,6 +502,10 @@ bool TaskDBManager::addTask(Task& task)
 
     task.id = query.lastInsertId().toInt();
     qDebug() << "新增任务成功，ID：" << task.id;
+
+    TaskChangeSet changes;
+    changes.added.append(task);
+    applyChanges(changes);
     return true;
 }
 
@@ -151,15 +513,20 @@ bool TaskDBManager::updateTask(const Task& task)
 {
     if (!isConnected() || task.id < 0) return false;
 
+    Task oldTask = lookupTask(task.id);
     Task updatedTask = task;
     updatedTask.updateTime = QDateTime::currentDateTime();
+    if (oldTask.id != -1) {
+        updatedTask.createTime = oldTask.createTime;
+    }
 
     QSqlQuery query(m_db);
     query.prepare(R"(
         UPDATE tasks SET
             title = :title, category = :category, priority = :priority,
             deadline = :deadline, is_completed = :is_completed, description = :description,
-            update_time = :update_time
+            update_time = :update_time, reminder_offsets = :reminder_offsets,
+            completed_at = CASE WHEN is_completed = 1 AND :keep_completed = 1 THEN completed_at ELSE :completed_at END
         WHERE id = :id
     )");
     QVariantMap taskMap = updatedTask.toMap();
@@ -170,6 +537,10 @@ bool TaskDBManager::updateTask(const Task& task)
     query.bindValue(":is_completed", taskMap["is_completed"]);
     query.bindValue(":description", taskMap["description"]);
     query.bindValue(":update_time", taskMap["update_time"]);
+    query.bindValue(":reminder_offsets", taskMap["reminder_offsets"]);
+    // 完成时间只在完成状态变化时改变：仍为已完成则保留原值，刚完成取本次更新时间，未完成清空
+    query.bindValue(":keep_completed", updatedTask.isCompleted ? 1 : 0);
+    query.bindValue(":completed_at", updatedTask.isCompleted ? taskMap["update_time"] : QVariant());
     query.bindValue(":id", task.id);
 
     if (!query.exec()) {
@@ -177,13 +548,20 @@ bool TaskDBManager::updateTask(const Task& task)
         return false;
     }
     qDebug() << "更新任务成功，ID：" << task.id;
-    return query.numRowsAffected() > 0;
+    if (query.numRowsAffected() <= 0) return false;
+
+    TaskChangeSet changes;
+    changes.updated.append(qMakePair(oldTask, updatedTask));
+    applyChanges(changes);
+    return true;
 }
 
 bool TaskDBManager::deleteTask(int taskId)
 {
     if (!isConnected() || taskId < 0) return false;
 
+    Task oldTask = lookupTask(taskId);
+
     QSqlQuery query(m_db);
     query.prepare("DELETE FROM tasks WHERE id = :id");
     query.bindValue(":id", taskId);
@@ -192,36 +570,325 @@ bool TaskDBManager::deleteTask(int taskId)
         return false;
     }
     qDebug() << "删除任务成功，ID：" << taskId;
-    return query.numRowsAffected() > 0;
+    if (query.numRowsAffected() <= 0) return false;
+
+    TaskChangeSet changes;
+    changes.removed.append(oldTask);
+    applyChanges(changes);
+    return true;
+}
+
+bool TaskDBManager::addTasks(QList<Task>& tasks)
+{
+    return importTasks(tasks, QList<Task>());
+}
+
+bool TaskDBManager::updateTasks(const QList<Task>& tasks)
+{
+    QList<Task> noTasks;
+    return importTasks(noTasks, tasks);
+}
+
+bool TaskDBManager::importTasks(QList<Task>& added, const QList<Task>& updated)
+{
+    if (!isConnected()) return false;
+    if (added.isEmpty() && updated.isEmpty()) return true;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    if (!m_db.transaction()) {
+        qCritical() << "开启事务失败：" << m_db.lastError().text();
+        return false;
+    }
+
+    // 新增和更新共用一个事务，任一条失败则全部回滚；每种语句预编译一次，循环内只重新绑定参数
+    QDateTime now = QDateTime::currentDateTime();
+    QList<int> newIds;
+    newIds.reserve(added.size());
+    if (!added.isEmpty()) {
+        QSqlQuery query(m_db);
+        query.prepare(R"(
+            INSERT INTO tasks (title, category, priority, deadline, is_completed, description, create_time, update_time, reminder_offsets, completed_at)
+            VALUES (:title, :category, :priority, :deadline, :is_completed, :description, :create_time, :update_time, :reminder_offsets, :completed_at)
+        )");
+
+        for (const Task& task : added) {
+            Task newTask = task;
+            newTask.createTime = now;
+            newTask.updateTime = now;
+
+            QVariantMap taskMap = newTask.toMap();
+            query.bindValue(":title", taskMap["title"]);
+            query.bindValue(":category", taskMap["category"]);
+            query.bindValue(":priority", taskMap["priority"]);
+            query.bindValue(":deadline", taskMap["deadline"]);
+            query.bindValue(":is_completed", taskMap["is_completed"]);
+            query.bindValue(":description", taskMap["description"]);
+            query.bindValue(":create_time", taskMap["create_time"]);
+            query.bindValue(":update_time", taskMap["update_time"]);
+            query.bindValue(":reminder_offsets", taskMap["reminder_offsets"]);
+            query.bindValue(":completed_at", newTask.isCompleted ? taskMap["create_time"] : QVariant());
+
+            if (!query.exec()) {
+                qCritical() << "批量新增任务失败：" << query.lastError().text();
+                m_db.rollback();
+                return false;
+            }
+            newIds.append(query.lastInsertId().toInt());
+        }
+    }
+
+    TaskChangeSet changes;
+    if (!updated.isEmpty()) {
+        QSqlQuery query(m_db);
+        query.prepare(R"(
+            UPDATE tasks SET
+                title = :title, category = :category, priority = :priority,
+                deadline = :deadline, is_completed = :is_completed, description = :description,
+                update_time = :update_time, reminder_offsets = :reminder_offsets,
+                completed_at = CASE WHEN is_completed = 1 AND :keep_completed = 1 THEN completed_at ELSE :completed_at END
+            WHERE id = :id
+        )");
+
+        for (const Task& task : updated) {
+            if (task.id < 0) continue;
+
+            Task oldTask = lookupTask(task.id);
+            Task updatedTask = task;
+            updatedTask.updateTime = now;
+            if (oldTask.id != -1) {
+                updatedTask.createTime = oldTask.createTime;
+            }
+
+            QVariantMap taskMap = updatedTask.toMap();
+            query.bindValue(":title", taskMap["title"]);
+            query.bindValue(":category", taskMap["category"]);
+            query.bindValue(":priority", taskMap["priority"]);
+            query.bindValue(":deadline", taskMap["deadline"]);
+            query.bindValue(":is_completed", taskMap["is_completed"]);
+            query.bindValue(":description", taskMap["description"]);
+            query.bindValue(":update_time", taskMap["update_time"]);
+            query.bindValue(":reminder_offsets", taskMap["reminder_offsets"]);
+            query.bindValue(":keep_completed", updatedTask.isCompleted ? 1 : 0);
+            query.bindValue(":completed_at", updatedTask.isCompleted ? taskMap["update_time"] : QVariant());
+            query.bindValue(":id", task.id);
+
+            if (!query.exec()) {
+                qCritical() << "批量更新任务失败：" << query.lastError().text();
+                m_db.rollback();
+                return false;
+            }
+            // 已不存在的任务跳过，不算失败
+            if (query.numRowsAffected() > 0) {
+                changes.updated.append(qMakePair(oldTask, updatedTask));
+            }
+        }
+    }
+
+    if (!m_db.commit()) {
+        qCritical() << "提交事务失败：" << m_db.lastError().text();
+        m_db.rollback();
+        return false;
+    }
+
+    // 提交成功后再回填ID和时间，失败时调用方的数据保持不变
+    for (int i = 0; i < added.size(); ++i) {
+        added[i].id = newIds[i];
+        added[i].createTime = now;
+        added[i].updateTime = now;
+    }
+
+    int written = added.size() + changes.updated.size();
+    qint64 elapsed = qMax<qint64>(timer.elapsed(), 1);
+    qDebug() << "批量写入任务成功：新增" << added.size() << "条，更新" << changes.updated.size()
+             << "条，耗时" << elapsed << "ms，约" << written * 1000 / elapsed << "条/秒";
+
+    changes.added = added;
+    applyChanges(changes);
+    return true;
+}
+
+bool TaskDBManager::deleteTasks(const QList<int>& taskIds)
+{
+    if (!isConnected()) return false;
+    if (taskIds.isEmpty()) return true;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QVariantList ids;
+    ids.reserve(taskIds.size());
+    TaskChangeSet changes;
+    for (int taskId : taskIds) {
+        if (taskId < 0) continue;
+        ids.append(taskId);
+
+        Task oldTask = lookupTask(taskId);
+        if (oldTask.id != -1) {
+            changes.removed.append(oldTask);
+        }
+    }
+
+    if (!m_db.transaction()) {
+        qCritical() << "开启事务失败：" << m_db.lastError().text();
+        return false;
+    }
+
+    QSqlQuery query(m_db);
+    query.prepare("DELETE FROM tasks WHERE id = ?");
+    query.addBindValue(ids);
+    if (!query.execBatch()) {
+        qCritical() << "批量删除任务失败：" << query.lastError().text();
+        m_db.rollback();
+        return false;
+    }
+
+    if (!m_db.commit()) {
+        qCritical() << "提交事务失败：" << m_db.lastError().text();
+        m_db.rollback();
+        return false;
+    }
+
+    qint64 elapsed = qMax<qint64>(timer.elapsed(), 1);
+    qDebug() << "批量删除任务成功：" << changes.removed.size() << "条，耗时" << elapsed << "ms，约"
+             << changes.removed.size() * 1000 / elapsed << "条/秒";
+
+    applyChanges(changes);
+    return true;
 }
 
 QList<Task> TaskDBManager::getAllTasks()
 {
-    QList<Task> tasks;
-    if (!isConnected()) return tasks;
+    QMutexLocker locker(&m_cacheMutex);
+    if (!m_cacheLoaded && !loadCacheLocked()) {
+        return QList<Task>();
+    }
+    // 返回的是隐式共享的副本，后续写操作会使缓存分离，不影响已取走的快照
+    return m_cacheTasks;
+}
+
+// QSqlDatabase连接不能跨线程使用，每个工作线程按线程建一个只读连接，线程结束时移除
+namespace {
+struct ThreadConnection {
+    QString name;
+    ~ThreadConnection()
+    {
+        if (!name.isEmpty()) QSqlDatabase::removeDatabase(name);
+    }
+};
+}
+
+QSqlDatabase TaskDBManager::threadConnection()
+{
+    // QThreadStorage在线程结束时delete存入的指针
+    static QThreadStorage<ThreadConnection*> connections;
+
+    if (!connections.hasLocalData()) {
+        ThreadConnection *connection = new ThreadConnection;
+        connection->name = QString("task_reader_%1").arg(quintptr(QThread::currentThreadId()));
+        {
+            QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connection->name);
+            db.setDatabaseName(m_dbPath);
+            // 主线程写入时短暂等待锁，而不是直接报SQLITE_BUSY
+            db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=2000;QSQLITE_OPEN_READONLY");
+            if (!db.open()) {
+                qCritical() << "工作线程数据库连接失败：" << db.lastError().text();
+            }
+        }
+        connections.setLocalData(connection);
+    }
+    return QSqlDatabase::database(connections.localData()->name);
+}
+
+quint64 TaskDBManager::cacheVersion() const
+{
+    QMutexLocker locker(&m_cacheMutex);
+    return m_cacheVersion;
+}
+
+bool TaskDBManager::loadCacheLocked()
+{
+    if (!isConnected()) return false;
 
     QSqlQuery query(m_db);
-    if (!query.exec("SELECT * FROM tasks")) {
+    if (!query.exec("SELECT * FROM tasks ORDER BY id ASC")) {
         qCritical() << "查询tasks表失败：" << query.lastError().text();
-        return tasks;
+        return false;
     }
 
+    m_cacheTasks.clear();
     while (query.next()) {
-        QVariantMap map;
-        map["id"] = query.value("id");
-        map["title"] = query.value("title");
-        map["category"] = query.value("category");
-        map["priority"] = query.value("priority");
-        map["deadline"] = query.value("deadline");
-        map["is_completed"] = query.value("is_completed");
-        map["description"] = query.value("description");
-        map["create_time"] = query.value("create_time");
-        map["update_time"] = query.value("update_time");
-        tasks.append(Task::fromMap(map));
+        m_cacheTasks.append(taskFromQuery(query));
     }
+    m_cacheLoaded = true;
 
-    qDebug() << "读取到的任务数：" << tasks.size();
-    return tasks;
+    qDebug() << "任务缓存已加载，任务数：" << m_cacheTasks.size();
+    return true;
+}
+
+int TaskDBManager::cacheIndexOfLocked(int taskId) const
+{
+    // 缓存按id升序，二分查找
+    auto it = std::lower_bound(m_cacheTasks.cbegin(), m_cacheTasks.cend(), taskId,
+                               [](const Task& task, int id) { return task.id < id; });
+    if (it == m_cacheTasks.cend() || it->id != taskId) return -1;
+    return int(it - m_cacheTasks.cbegin());
+}
+
+Task TaskDBManager::lookupTask(int taskId)
+{
+    QMutexLocker locker(&m_cacheMutex);
+    if (m_cacheLoaded) {
+        int index = cacheIndexOfLocked(taskId);
+        return index < 0 ? Task() : m_cacheTasks.at(index);
+    }
+
+    // 缓存尚未加载（列表分页显示时不需要全部任务），只按主键取这一条
+    if (!isConnected()) return Task();
+    QSqlQuery query(m_db);
+    query.prepare("SELECT * FROM tasks WHERE id = :id");
+    query.bindValue(":id", taskId);
+    if (!query.exec()) {
+        qCritical() << "按ID查询任务失败：" << query.lastError().text();
+        return Task();
+    }
+    return query.next() ? taskFromQuery(query) : Task();
+}
+
+void TaskDBManager::applyChanges(const TaskChangeSet& changes)
+{
+    if (changes.isEmpty()) return;
+
+    {
+        QMutexLocker locker(&m_cacheMutex);
+        if (m_cacheLoaded) {
+            for (const Task& task : changes.added) {
+                auto it = std::lower_bound(m_cacheTasks.begin(), m_cacheTasks.end(), task.id,
+                                           [](const Task& cached, int id) { return cached.id < id; });
+                m_cacheTasks.insert(it, task);
+            }
+            for (const auto& change : changes.updated) {
+                int index = cacheIndexOfLocked(change.second.id);
+                if (index >= 0) m_cacheTasks[index] = change.second;
+            }
+            // 批量删除一次过滤完成，不逐条removeAt
+            if (!changes.removed.isEmpty()) {
+                QSet<int> removedIds;
+                removedIds.reserve(changes.removed.size());
+                for (const Task& task : changes.removed) removedIds.insert(task.id);
+                m_cacheTasks.erase(std::remove_if(m_cacheTasks.begin(), m_cacheTasks.end(),
+                                                  [&removedIds](const Task& task) {
+                                                      return removedIds.contains(task.id);
+                                                  }),
+                                   m_cacheTasks.end());
+            }
+        }
+        m_cacheVersion++;
+    }
+
+    // 锁外发信号，避免接收方回调读取缓存时死锁
+    emit tasksChanged(changes);
 }
 
 QList<Task> TaskDBManager::getUncompletedTasks()
@@ -230,51 +897,26 @@ QList<Task> TaskDBManager::getUncompletedTasks()
     if (!isConnected()) return tasks;
 
     QSqlQuery query(m_db);
-    if (!query.exec("SELECT * FROM tasks WHERE is_completed = 0 ORDER BY deadline ASC")) {
+    if (!query.exec(kSqlUncompletedTasks)) {
         qCritical() << "查询未完成任务失败：" << query.lastError().text();
         return tasks;
     }
 
     while (query.next()) {
-        QVariantMap map;
-        map["id"] = query.value("id");
-        map["title"] = query.value("title");
-        map["category"] = query.value("category");
-        map["priority"] = query.value("priority");
-        map["deadline"] = query.value("deadline");
-        map["is_completed"] = query.value("is_completed");
-        map["description"] = query.value("description");
-        map["create_time"] = query.value("create_time");
-        map["update_time"] = query.value("update_time");
-        tasks.append(Task::fromMap(map));
+        tasks.append(taskFromQuery(query));
     }
     return tasks;
 }
 
 Task TaskDBManager::getTaskById(int taskId)
 {
-    Task task;
-    if (!isConnected() || taskId < 0) return task;
+    if (!isConnected() || taskId < 0) return Task();
 
-    QSqlQuery query(m_db);
-    query.prepare("SELECT * FROM tasks WHERE id = :id");
-    query.bindValue(":id", taskId);
-    if (!query.exec() || !query.next()) {
+    Task task = lookupTask(taskId);
+    if (task.id == -1) {
         qWarning() << "未找到ID为" << taskId << "的任务";
-        return task;
     }
-
-    QVariantMap map;
-    map["id"] = query.value("id");
-    map["title"] = query.value("title");
-    map["category"] = query.value("category");
-    map["priority"] = query.value("priority");
-    map["deadline"] = query.value("deadline");
-    map["is_completed"] = query.value("is_completed");
-    map["description"] = query.value("description");
-    map["create_time"] = query.value("create_time");
-    map["update_time"] = query.value("update_time");
-    return Task::fromMap(map);
+    return task;
 }
 
 QList<Task> TaskDBManager::getTasksByCategory(const QString& category)
@@ -283,7 +925,7 @@ QList<Task> TaskDBManager::getTasksByCategory(const QString& category)
     if (!isConnected()) return tasks;
 
     QSqlQuery query(m_db);
-    query.prepare("SELECT * FROM tasks WHERE category = :category ORDER BY priority DESC");
+    query.prepare(kSqlTasksByCategory);
     query.bindValue(":category", category);
     if (!query.exec()) {
         qCritical() << "按分类查询任务失败：" << query.lastError().text();
@@ -291,38 +933,320 @@ QList<Task> TaskDBManager::getTasksByCategory(const QString& category)
     }
 
     while (query.next()) {
-        QVariantMap map;
-        map["id"] = query.value("id");
-        map["title"] = query.value("title");
-        map["category"] = query.value("category");
-        map["priority"] = query.value("priority");
-        map["deadline"] = query.value("deadline");
-        map["is_completed"] = query.value("is_completed");
-        map["description"] = query.value("description");
-        map["create_time"] = query.value("create_time");
-        map["update_time"] = query.value("update_time");
-        tasks.append(Task::fromMap(map));
+        tasks.append(taskFromQuery(query));
+    }
+    return tasks;
+}
+
+QList<Task> TaskDBManager::searchTasks(const QString& text, int limit)
+{
+    QList<Task> tasks;
+    if (!isConnected() || limit <= 0) return tasks;
+
+    QStringList terms = text.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
+    if (terms.isEmpty()) return tasks;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // trigram至少需要3个字符才能命中索引，更短的词（如两个汉字）退化为LIKE
+    bool useFts = m_ftsAvailable;
+    if (useFts && m_ftsTrigram) {
+        for (const QString& term : terms) {
+            if (term.size() < 3) {
+                useFts = false;
+                break;
+            }
+        }
+    }
+
+    QSqlQuery query(m_db);
+    if (useFts) {
+        // 每个词作为短语（双引号转义），词之间为AND；unicode61分词时按前缀匹配
+        QStringList phrases;
+        for (QString term : terms) {
+            term.replace("\"", "\"\"");
+            phrases << (m_ftsTrigram ? QString("\"%1\"").arg(term) : QString("\"%1\"*").arg(term));
+        }
+        query.prepare(R"(
+            SELECT tasks.* FROM tasks_fts
+            JOIN tasks ON tasks.id = tasks_fts.rowid
+            WHERE tasks_fts MATCH :match
+            ORDER BY tasks_fts.rank
+            LIMIT :limit
+        )");
+        query.bindValue(":match", phrases.join(" "));
+    } else {
+        QStringList conditions;
+        for (int i = 0; i < terms.size(); ++i) {
+            conditions << QString("(title LIKE :t%1 ESCAPE '\\' OR description LIKE :d%1 ESCAPE '\\')").arg(i);
+        }
+        query.prepare(QString("SELECT * FROM tasks WHERE %1 ORDER BY update_time DESC LIMIT :limit")
+                          .arg(conditions.join(" AND ")));
+        for (int i = 0; i < terms.size(); ++i) {
+            QString pattern = terms[i];
+            pattern.replace("\\", "\\\\").replace("%", "\\%").replace("_", "\\_");
+            pattern = "%" + pattern + "%";
+            query.bindValue(QString(":t%1").arg(i), pattern);
+            query.bindValue(QString(":d%1").arg(i), pattern);
+        }
+    }
+    query.bindValue(":limit", limit);
+
+    if (!query.exec()) {
+        qCritical() << "搜索任务失败：" << query.lastError().text();
+        return tasks;
+    }
+    while (query.next()) {
+        tasks.append(taskFromQuery(query));
+    }
+
+    // 目标：百万级任务下单次检索在50ms内完成
+    qint64 elapsed = timer.elapsed();
+    if (elapsed > 50) {
+        qWarning() << "搜索耗时超出目标：" << text << elapsed << "ms" << (useFts ? "(FTS5)" : "(LIKE)");
+    } else {
+        qDebug() << "搜索「" << text << "」命中" << tasks.size() << "条，耗时" << elapsed << "ms";
     }
     return tasks;
 }
 
+QList<Task> TaskDBManager::getTasksPage(TaskSortKey sortKey, bool ascending, const Task& after, int limit,
+                                        const QString& category)
+{
+    QList<Task> tasks;
+    if (!isConnected() || limit <= 0) return tasks;
+
+    QSqlQuery query(m_db);
+    query.prepare(pageSql(sortKey, ascending, !category.isEmpty(), after.id >= 0));
+    if (!category.isEmpty()) {
+        query.bindValue(":category", category);
+    }
+    if (after.id >= 0) {
+        if (sortKey == TaskSortKey::Priority) {
+            query.bindValue(":afterKey", after.priority);
+        } else {
+            query.bindValue(":afterKey", after.updateTime.toString("yyyy-MM-dd HH:mm:ss"));
+        }
+        query.bindValue(":afterId", after.id);
+    }
+    query.bindValue(":limit", limit);
+
+    if (!query.exec()) {
+        qCritical() << "分页查询任务失败：" << query.lastError().text();
+        return tasks;
+    }
+
+    tasks.reserve(limit);
+    while (query.next()) {
+        tasks.append(taskFromQuery(query));
+    }
+    return tasks;
+}
+
+TaskAggregates TaskDBManager::getTaskAggregates(const QDateTime& now)
+{
+    if (!isConnected()) return TaskAggregates();
+    return getTaskAggregates(m_db, now);
+}
+
+TaskAggregates TaskDBManager::getTaskAggregates(QSqlDatabase db, const QDateTime& now)
+{
+    TaskAggregates result;
+
+    // 沿idx_tasks_category_priority顺序扫描分组，不读取任务内容
+    QString nowStr = now.toString("yyyy-MM-dd HH:mm:ss");
+    QSqlQuery query(db);
+    query.prepare(kSqlTaskAggregates);
+    query.bindValue(":now", nowStr);
+    query.bindValue(":nowNext", nowStr);
+    if (!query.exec()) {
+        qCritical() << "聚合统计任务失败：" << query.lastError().text();
+        return result;
+    }
+
+    result.valid = true;
+    QString nextDeadline;
+    while (query.next()) {
+        TaskCountRow row;
+        row.category = query.value(0).toString();
+        row.priority = query.value(1).toInt();
+        row.total = query.value(2).toInt();
+        row.completed = query.value(3).toInt();
+        row.overdue = query.value(4).toInt();
+        result.groups.append(row);
+
+        // 截止时间为定长文本，可直接按字符串比较
+        QString groupNext = query.value(5).toString();
+        if (!groupNext.isEmpty() && (nextDeadline.isEmpty() || groupNext < nextDeadline)) {
+            nextDeadline = groupNext;
+        }
+    }
+    if (!nextDeadline.isEmpty()) {
+        result.nextDeadline = QDateTime::fromString(nextDeadline, "yyyy-MM-dd HH:mm:ss");
+    }
+    return result;
+}
+
+TaskOverdueState TaskDBManager::getOverdueState(const QDateTime& now)
+{
+    if (!isConnected()) return TaskOverdueState();
+    return getOverdueState(m_db, now);
+}
+
+TaskOverdueState TaskDBManager::getOverdueState(QSqlDatabase db, const QDateTime& now)
+{
+    TaskOverdueState result;
+
+    QString nowStr = now.toString("yyyy-MM-dd HH:mm:ss");
+    QSqlQuery query(db);
+    query.prepare(kSqlOverdueState);
+    query.bindValue(":now", nowStr);
+    query.bindValue(":nowNext", nowStr);
+    if (!query.exec() || !query.next()) {
+        qCritical() << "查询逾期任务失败：" << query.lastError().text();
+        return result;
+    }
+
+    result.valid = true;
+    result.overdue = query.value(0).toInt();
+    QString nextDeadline = query.value(1).toString();
+    if (!nextDeadline.isEmpty()) {
+        result.nextDeadline = QDateTime::fromString(nextDeadline, "yyyy-MM-dd HH:mm:ss");
+    }
+    return result;
+}
+
+QList<TaskDailyStat> TaskDBManager::getDailyStats(const QDate& from, const QDate& to)
+{
+    if (!isConnected()) return QList<TaskDailyStat>();
+    return getDailyStats(m_db, from, to);
+}
+
+QList<TaskDailyStat> TaskDBManager::getDailyStats(QSqlDatabase db, const QDate& from, const QDate& to)
+{
+    QList<TaskDailyStat> stats;
+
+    // 主键范围查询
+    QSqlQuery query(db);
+    query.prepare("SELECT day, created, completed, due_total, due_open FROM task_daily_stats "
+                  "WHERE day BETWEEN :from AND :to ORDER BY day");
+    query.bindValue(":from", from.toString("yyyy-MM-dd"));
+    query.bindValue(":to", to.toString("yyyy-MM-dd"));
+    if (!query.exec()) {
+        qCritical() << "查询按日统计失败：" << query.lastError().text();
+        return stats;
+    }
+    while (query.next()) {
+        TaskDailyStat stat;
+        stat.day = QDate::fromString(query.value(0).toString(), "yyyy-MM-dd");
+        stat.created = query.value(1).toInt();
+        stat.completed = query.value(2).toInt();
+        stat.dueTotal = query.value(3).toInt();
+        stat.dueOpen = query.value(4).toInt();
+        stats.append(stat);
+    }
+    return stats;
+}
+
+QList<QPair<int, int>> TaskDBManager::getFiredReminders()
+{
+    QList<QPair<int, int>> reminders;
+    if (!isConnected()) return reminders;
+
+    QSqlQuery query(m_db);
+    if (!query.exec("SELECT task_id, kind FROM task_reminder_log")) {
+        qCritical() << "查询提醒记录失败：" << query.lastError().text();
+        return reminders;
+    }
+    while (query.next()) {
+        reminders.append(qMakePair(query.value(0).toInt(), query.value(1).toInt()));
+    }
+    return reminders;
+}
+
+bool TaskDBManager::markRemindersFired(const QList<QPair<int, int>>& reminders)
+{
+    if (!isConnected()) return false;
+    if (reminders.isEmpty()) return true;
+
+    QVariantList taskIds, kinds, firedAts;
+    QString now = QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss");
+    for (const auto& reminder : reminders) {
+        taskIds << reminder.first;
+        kinds << reminder.second;
+        firedAts << now;
+    }
+
+    if (!m_db.transaction()) {
+        qCritical() << "开启事务失败：" << m_db.lastError().text();
+        return false;
+    }
+
+    QSqlQuery query(m_db);
+    query.prepare("INSERT OR REPLACE INTO task_reminder_log (task_id, kind, fired_at) VALUES (?, ?, ?)");
+    query.addBindValue(taskIds);
+    query.addBindValue(kinds);
+    query.addBindValue(firedAts);
+    if (!query.execBatch()) {
+        qCritical() << "写入提醒记录失败：" << query.lastError().text();
+        m_db.rollback();
+        return false;
+    }
+    return m_db.commit();
+}
+
+void TaskDBManager::benchmarkQueries(int rounds)
+{
+    if (!isConnected() || rounds <= 0) return;
+
+    // 分页游标取第一页最后一条，模拟滚动加载第二页
+    QList<Task> firstPage = getTasksPage(TaskSortKey::UpdateTime, false, Task(), 200);
+    Task cursor = firstPage.isEmpty() ? Task() : firstPage.last();
+
+    QList<QPair<QString, std::function<void()>>> cases = {
+        {"getUncompletedTasks", [this]() { getUncompletedTasks(); }},
+        {"getTasksByCategory", [this]() { getTasksByCategory("工作"); }},
+        {"getLatestTask", [this]() { getLatestTask(); }},
+        {"getOverdueState", [this]() { getOverdueState(QDateTime::currentDateTime()); }},
+        {"getTasksPage(首页)", [this]() { getTasksPage(TaskSortKey::UpdateTime, false, Task(), 200); }},
+        {"getTasksPage(续页)", [this, cursor]() { getTasksPage(TaskSortKey::UpdateTime, false, cursor, 200); }},
+        {"getTasksPage(分类+优先级)", [this]() { getTasksPage(TaskSortKey::Priority, false, Task(), 200, "工作"); }},
+        // trigram分词下每个词至少3个字符才走FTS5，两个字的词退化为LIKE，两条路径分别计时
+        {"searchTasks(FTS5)", [this]() { searchTasks("工作报告 年度总结", 50); }},
+        {"searchTasks(短词LIKE)", [this]() { searchTasks("报告", 50); }},
+        {"getAllTasks(缓存)", [this]() { getAllTasks(); }}
+    };
+
+    qDebug() << "===== 查询性能基准（每项" << rounds << "次）=====";
+    for (const auto& benchCase : cases) {
+        qint64 totalNs = 0, maxNs = 0;
+        for (int i = 0; i < rounds; ++i) {
+            QElapsedTimer timer;
+            timer.start();
+            benchCase.second();
+            qint64 ns = timer.nsecsElapsed();
+            totalNs += ns;
+            maxNs = qMax(maxNs, ns);
+        }
+        qDebug().noquote() << QString("%1：平均 %2 ms，最慢 %3 ms")
+                                  .arg(benchCase.first, -28)
+                                  .arg(totalNs / rounds / 1e6, 0, 'f', 3)
+                                  .arg(maxNs / 1e6, 0, 'f', 3);
+    }
+}
+
 Task TaskDBManager::getLatestTask()
 {
     Task latestTask;
     if (!isConnected()) return latestTask;
 
     QDateTime now = QDateTime::currentDateTime();
-    // 1. 执行严格SQL：仅未完成+截止时间>当前时间
-    QString sql = QString(R"(
-        SELECT * FROM tasks
-        WHERE is_completed = 0
-          AND deadline > '%1'
-        ORDER BY deadline ASC
-        LIMIT 1
-    )").arg(now.toString("yyyy-MM-dd HH:mm:ss"));
-
+    // 1. 执行严格SQL：仅未完成+截止时间>当前时间（走部分索引idx_tasks_open_deadline）
     QSqlQuery query(m_db);
-    if (!query.exec(sql)) {
+    query.prepare(kSqlLatestTask);
+    query.bindValue(":now", now.toString("yyyy-MM-dd HH:mm:ss"));
+    if (!query.exec()) {
         qCritical() << "查询最近任务失败：" << query.lastError().text();
         return latestTask;
     }
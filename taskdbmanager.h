@@ -8,6 +8,10 @@
 #include <QList>
 #include <QDateTime>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QPair>
+#include <QHash>
 
 struct Task {
     int id = -1;                      // 主键（-1表示未入库）
@@ -19,6 +23,7 @@ struct Task {
     QString description;              // 描述
     QDateTime createTime;             // 创建时间
     QDateTime updateTime;             // 更新时间
+    QList<int> reminderOffsets;       // 截止前提醒的分钟数（从大到小），为空时使用全局阈值
 
     // 结构体转QVariantMap（核心修改：去掉T，统一格式）
     QVariantMap toMap() const {
@@ -32,6 +37,10 @@ struct Task {
         map["description"] = description;
         map["create_time"] = createTime.toString("yyyy-MM-dd HH:mm:ss");
         map["update_time"] = updateTime.toString("yyyy-MM-dd HH:mm:ss");
+        // 提醒提前量存为逗号分隔的分钟数
+        QStringList offsets;
+        for (int minutes : reminderOffsets) offsets << QString::number(minutes);
+        map["reminder_offsets"] = offsets.join(",");
         return map;
     }
 
@@ -70,10 +79,62 @@ struct Task {
         }
         task.updateTime = updateTime;
 
+        const QStringList offsets = map["reminder_offsets"].toString().split(",", Qt::SkipEmptyParts);
+        for (const QString& offset : offsets) {
+            int minutes = offset.toInt();
+            if (minutes > 0) task.reminderOffsets.append(minutes);
+        }
+
         return task;
     }
 };
 
+// 一次写操作产生的变更集合，随tasksChanged信号下发给缓存的使用者
+struct TaskChangeSet {
+    QList<Task> added;                  // 新增的任务（已回填ID）
+    QList<QPair<Task, Task>> updated;   // 修改的任务（旧值, 新值）
+    QList<Task> removed;                // 删除的任务（删除前的值）
+
+    bool isEmpty() const { return added.isEmpty() && updated.isEmpty() && removed.isEmpty(); }
+};
+Q_DECLARE_METATYPE(TaskChangeSet)
+
+// 按(分类, 优先级)分组的聚合结果，用于统计
+struct TaskCountRow {
+    QString category;
+    int priority = 3;
+    int total = 0;
+    int completed = 0;
+    int overdue = 0;                  // 未完成且已过截止时间
+};
+
+struct TaskAggregates {
+    QList<TaskCountRow> groups;
+    QDateTime nextDeadline;           // 最近一个尚未到期的未完成任务截止时间，逾期数在此之前不变
+    bool valid = false;               // 查询是否成功
+};
+
+// 逾期数及下一个截止时间，只随时间或写操作变化
+struct TaskOverdueState {
+    int overdue = 0;
+    QDateTime nextDeadline;           // 无效表示没有待到期的未完成任务
+    bool valid = false;
+};
+
+// task_daily_stats中的一天：当天创建数、完成数、到期数及其中仍未完成的数量
+struct TaskDailyStat {
+    QDate day;
+    int created = 0;
+    int completed = 0;
+    int dueTotal = 0;
+    int dueOpen = 0;
+};
+
+// 任务列表分页排序键（id作为第二排序键，与排序键同向，保证顺序稳定）
+enum class TaskSortKey {
+    UpdateTime,   // (update_time, id)
+    Priority      // (priority, id)
+};
 
 class TaskDBManager : public QObject
 {
@@ -83,10 +144,34 @@ private:
     ~TaskDBManager() override;
 
     QSqlDatabase m_db;  // 数据库连接
+    QString m_dbPath;   // 数据库文件路径（构造后只读，工作线程建连接时使用）
 
     // 初始化表结构
     bool initTables();
     bool isTableExists(const QString& tableName);
+    bool isColumnExists(const QString& tableName, const QString& columnName);
+    // 初始化全文检索（FTS5虚表+同步触发器）
+    bool initFullTextSearch();
+    bool m_ftsAvailable = false;   // FTS5可用
+    bool m_ftsTrigram = false;     // 使用trigram分词（支持中文子串检索）
+    // 初始化提醒记录表（已触发的提醒，重启后不重复/不遗漏）
+    bool initReminderLog();
+    bool initDailyStats();
+    // 启动自检：EXPLAIN QUERY PLAN各查询，记录全表扫描/临时排序
+    void checkQueryPlans();
+    // 查询结果当前行转Task
+    static Task taskFromQuery(const QSqlQuery& query);
+
+    // 任务缓存：按id升序保存全部任务，首次调用getAllTasks时从数据库加载一次，
+    // 之后由增删改增量维护；QList隐式共享，读者拿到的副本即不可变快照
+    mutable QMutex m_cacheMutex;
+    QList<Task> m_cacheTasks;
+    bool m_cacheLoaded = false;
+    quint64 m_cacheVersion = 0;          // 每次变更+1
+    bool loadCacheLocked();              // 调用方需持有m_cacheMutex
+    int cacheIndexOfLocked(int taskId) const;
+    Task lookupTask(int taskId);         // 取任务当前值（优先缓存）
+    void applyChanges(const TaskChangeSet& changes);
 
 public:
     static TaskDBManager* getInstance();// 单例获取
@@ -96,12 +181,49 @@ public:
     bool addTask(Task& task);
     bool updateTask(const Task& task);
     bool deleteTask(int taskId);
-    QList<Task> getAllTasks();
+    // 批量操作：整体在一个事务内执行，任一条失败则全部回滚；
+    // 事务提交即返回true，已不存在的ID跳过，不算失败
+    bool addTasks(QList<Task>& tasks);          // 成功后回填每个任务的ID
+    bool updateTasks(const QList<Task>& tasks);
+    bool deleteTasks(const QList<int>& taskIds);
+    // 新增和更新在同一个事务内写入（用于导入），成功后回填added的ID
+    bool importTasks(QList<Task>& added, const QList<Task>& updated);
+    QList<Task> getAllTasks();          // 返回缓存快照，至多读一次数据库
+    quint64 cacheVersion() const;       // 缓存版本号，可用于判断数据是否变化
     QList<Task> getUncompletedTasks();
     Task getTaskById(int taskId);
     QList<Task> getTasksByCategory(const QString& category);
     Task getLatestTask();
-
+    // 全文检索标题和描述，按相关度排序返回至多limit条
+    QList<Task> searchTasks(const QString& text, int limit);
+    // 键集分页：返回排在after之后的至多limit条任务，after.id为-1时取第一页；category为空表示全部分类
+    QList<Task> getTasksPage(TaskSortKey sortKey, bool ascending, const Task& after, int limit,
+                             const QString& category = QString());
+
+    // 一次GROUP BY查询得到计数、完成数、逾期数（按now判断）及下一个截止时间
+    TaskAggregates getTaskAggregates(const QDateTime& now);
+    // 只查逾期数和下一个截止时间，走部分索引idx_tasks_open_deadline，不做全表分组
+    TaskOverdueState getOverdueState(const QDateTime& now);
+    // [from, to]内有记录的日期（按日期升序，无记录的日期不返回）
+    QList<TaskDailyStat> getDailyStats(const QDate& from, const QDate& to);
+
+    // 工作线程使用：在当前线程专用连接上执行同样的只读查询
+    QSqlDatabase threadConnection();
+    static TaskAggregates getTaskAggregates(QSqlDatabase db, const QDateTime& now);
+    static TaskOverdueState getOverdueState(QSqlDatabase db, const QDateTime& now);
+    static QList<TaskDailyStat> getDailyStats(QSqlDatabase db, const QDate& from, const QDate& to);
+
+    // 已触发的提醒(task_id, kind)，kind为0表示截止提醒、大于0表示提前的分钟数；
+    // 任务完成/删除/改期时由触发器清理
+    QList<QPair<int, int>> getFiredReminders();
+    bool markRemindersFired(const QList<QPair<int, int>>& reminders);  // (task_id, kind)
+
+    // 查询性能基准：每个查询方法执行rounds次，输出平均/最慢耗时
+    void benchmarkQueries(int rounds = 20);
+
+signals:
+    // 任务增删改成功后发出（缓存已更新）
+    void tasksChanged(const TaskChangeSet& changes);
 
 private:
     static TaskDBManager* m_instance;  // 单例实例
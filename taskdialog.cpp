@@ -2,6 +2,9 @@
 #include "ui_taskdialog.h"
 #include <QMessageBox>
 #include <QDateTime>
+#include <QRegularExpression>
+#include <algorithm>
+#include <functional>
 
 // 构造函数
 TaskDialog::TaskDialog(bool isEdit, const Task& task, QWidget *parent)
@@ -23,6 +26,10 @@ TaskDialog::TaskDialog(bool isEdit, const Task& task, QWidget *parent)
         ui->deadline->setDateTime(m_task.deadline);
         ui->iscomplete->setChecked(m_task.isCompleted);
         ui->description->setPlainText(m_task.description);
+
+        QStringList offsets;
+        for (int minutes : m_task.reminderOffsets) offsets << QString::number(minutes);
+        ui->reminderOffsets->setText(offsets.join(","));
     }
 }
 
@@ -65,6 +72,21 @@ void TaskDialog::on_okBtn_clicked()
     m_task.isCompleted = ui->iscomplete->isChecked();
     m_task.description = ui->description->toPlainText().trimmed();
 
+    // 提前提醒：支持中英文逗号/空格分隔，去重后从大到小排列
+    QList<int> offsets;
+    const QStringList parts = ui->reminderOffsets->text().split(QRegularExpression("[,，\\s]+"), Qt::SkipEmptyParts);
+    for (const QString& part : parts) {
+        bool ok = false;
+        int minutes = part.toInt(&ok);
+        if (!ok || minutes <= 0) {
+            QMessageBox::warning(this, "提示", QString("提前提醒时间「%1」无效，请填写正整数分钟数！").arg(part));
+            return;
+        }
+        if (!offsets.contains(minutes)) offsets.append(minutes);
+    }
+    std::sort(offsets.begin(), offsets.end(), std::greater<int>());
+    m_task.reminderOffsets = offsets;
+
     if (!m_isEdit) {
         m_task.id = -1;
         m_task.createTime = QDateTime::currentDateTime();
@@ -1,18 +1,148 @@
 #include "taskstatistic.h"
 
-QMap<QString, QPair<int, int>> TaskStatistic::statByCategory()
+TaskStatEngine* TaskStatEngine::m_instance = nullptr;
+
+TaskStatEngine::TaskStatEngine(QObject *parent) : QObject(parent)
+{
+    // 与TaskDBManager同在主线程，直接连接，写操作返回前统计即已更新
+    connect(TaskDBManager::getInstance(), &TaskDBManager::tasksChanged,
+            this, &TaskStatEngine::onTasksChanged);
+}
+
+TaskStatEngine* TaskStatEngine::getInstance()
+{
+    if (!m_instance) {
+        m_instance = new TaskStatEngine();
+    }
+    return m_instance;
+}
+
+void TaskStatEngine::ensureSeeded()
 {
-    QMap<QString, QPair<int, int>> statMap;
-    QList<Task> tasks = TaskDBManager::getInstance()->getAllTasks();
+    if (!m_seeded) reload();
+}
 
-    for (const Task& task : tasks) {
-        if (!statMap.contains(task.category)) statMap[task.category] = {0, 0};
+void TaskStatEngine::reload()
+{
+    QDateTime now = QDateTime::currentDateTime();
+    applyAggregates(TaskDBManager::getInstance()->getTaskAggregates(now));
+}
 
-        if (task.isCompleted) statMap[task.category].first++;
-        else statMap[task.category].second++;
+void TaskStatEngine::applyAggregates(const TaskAggregates& aggregates)
+{
+    m_total = m_unfinished = m_overdue = 0;
+    m_byCategory.clear();
+    m_byPriority.clear();
+    for (const TaskCountRow& row : aggregates.groups) {
+        int unfinished = row.total - row.completed;
+        QPair<int, int>& categoryCount = m_byCategory[row.category];
+        categoryCount.first += row.completed;
+        categoryCount.second += unfinished;
+        QPair<int, int>& priorityCount = m_byPriority[row.priority];
+        priorityCount.first += row.completed;
+        priorityCount.second += unfinished;
+        m_total += row.total;
+        m_unfinished += unfinished;
+        m_overdue += row.overdue;
     }
+    m_overdueValidUntil = aggregates.nextDeadline;
 
-    return statMap;
+    if (!m_seeded) {
+        qDebug() << "统计引擎初始化完成，总任务：" << m_total << "未完成：" << m_unfinished << "逾期：" << m_overdue;
+    }
+    m_seeded = true;
+}
+
+void TaskStatEngine::applyOverdue(const TaskOverdueState& state)
+{
+    if (!state.valid) return;
+    m_overdue = state.overdue;
+    m_overdueValidUntil = state.nextDeadline;
+}
+
+void TaskStatEngine::onTasksChanged(const TaskChangeSet& changes)
+{
+    // 尚未初始化时不用处理，初始化时的查询已包含这些变更
+    if (!m_seeded) return;
+
+    QDateTime now = QDateTime::currentDateTime();
+    for (const Task& task : changes.added) count(task, 1, now);
+    for (const auto& change : changes.updated) {
+        count(change.first, -1, now);
+        count(change.second, 1, now);
+    }
+    for (const Task& task : changes.removed) count(task, -1, now);
+}
+
+void TaskStatEngine::count(const Task& task, int delta, const QDateTime& now)
+{
+    QPair<int, int>& categoryCount = m_byCategory[task.category];
+    QPair<int, int>& priorityCount = m_byPriority[task.priority];
+    if (task.isCompleted) {
+        categoryCount.first += delta;
+        priorityCount.first += delta;
+    } else {
+        categoryCount.second += delta;
+        priorityCount.second += delta;
+        m_unfinished += delta;
+        // 与聚合查询的判断一致：未完成且已过截止时间（无截止时间存为空串）为逾期，
+        // 新出现的更早截止时间会提前逾期数的失效时间
+        if (!task.deadline.isValid() || task.deadline < now) {
+            m_overdue += delta;
+        } else if (delta > 0 && (!m_overdueValidUntil.isValid() || task.deadline < m_overdueValidUntil)) {
+            m_overdueValidUntil = task.deadline;
+        }
+    }
+    m_total += delta;
+
+    // 计数归零的分类/优先级不再显示
+    if (categoryCount.first == 0 && categoryCount.second == 0) m_byCategory.remove(task.category);
+    if (priorityCount.first == 0 && priorityCount.second == 0) m_byPriority.remove(task.priority);
+}
+
+int TaskStatEngine::total()
+{
+    ensureSeeded();
+    return m_total;
+}
+
+int TaskStatEngine::unfinished()
+{
+    ensureSeeded();
+    return m_unfinished;
+}
+
+int TaskStatEngine::overdue()
+{
+    ensureSeeded();
+    // 已有任务到期：刷新调度器会在到期时重查，这里兜底用索引查询补上，不重新分组聚合
+    QDateTime now = QDateTime::currentDateTime();
+    if (m_overdueValidUntil.isValid() && now >= m_overdueValidUntil) {
+        applyOverdue(TaskDBManager::getInstance()->getOverdueState(now));
+    }
+    return m_overdue;
+}
+
+QMap<QString, QPair<int, int>> TaskStatEngine::byCategory()
+{
+    ensureSeeded();
+    return m_byCategory;
+}
+
+QMap<int, QPair<int, int>> TaskStatEngine::byPriority()
+{
+    ensureSeeded();
+    return m_byPriority;
+}
+
+QMap<QString, QPair<int, int>> TaskStatistic::statByCategory()
+{
+    return TaskStatEngine::getInstance()->byCategory();
+}
+
+QMap<int, QPair<int, int>> TaskStatistic::statByPriority()
+{
+    return TaskStatEngine::getInstance()->byPriority();
 }
 
 float TaskStatistic::getCompletionRate()
@@ -25,11 +155,48 @@ float TaskStatistic::getCompletionRate()
 
 void TaskStatistic::statTotal(int& total, int& unfinished)
 {
-    QList<Task> tasks = TaskDBManager::getInstance()->getAllTasks();
-    total = tasks.size();
-    unfinished = 0;
+    TaskStatEngine *engine = TaskStatEngine::getInstance();
+    total = engine->total();
+    unfinished = engine->unfinished();
+}
+
+int TaskStatistic::statOverdue()
+{
+    return TaskStatEngine::getInstance()->overdue();
+}
+
+QList<TaskTrendPoint> TaskStatistic::statTrend(const QDate& from, const QDate& to, TrendBucket bucket)
+{
+    return statTrend(TaskDBManager::getInstance()->getDailyStats(from, to), from, to, bucket);
+}
+
+QList<TaskTrendPoint> TaskStatistic::statTrend(const QList<TaskDailyStat>& stats, const QDate& from,
+                                               const QDate& to, TrendBucket bucket)
+{
+    QList<TaskTrendPoint> points;
+    if (!from.isValid() || !to.isValid() || from > to) return points;
+
+    // 按周时把起点对齐到周一
+    auto bucketStart = [bucket](const QDate& day) {
+        return bucket == TrendBucket::Week ? day.addDays(1 - day.dayOfWeek()) : day;
+    };
+    int step = (bucket == TrendBucket::Week) ? 7 : 1;
+    QDate first = bucketStart(from);
+    for (QDate start = first; start <= to; start = start.addDays(step)) {
+        TaskTrendPoint point;
+        point.start = start;
+        points.append(point);
+    }
 
-    for (const Task& task : tasks) {
-        if (!task.isCompleted) unfinished++;
+    // 截止日在今天之前仍未完成的即为逾期
+    QDate today = QDate::currentDate();
+    for (const TaskDailyStat& stat : stats) {
+        int index = first.daysTo(bucketStart(stat.day)) / step;
+        if (index < 0 || index >= points.size()) continue;
+        TaskTrendPoint& point = points[index];
+        point.created += stat.created;
+        point.completed += stat.completed;
+        if (stat.day < today) point.overdue += stat.dueOpen;
     }
+    return points;
 }
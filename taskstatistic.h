@@ -1,16 +1,76 @@
 #ifndef TASKSTATISTIC_H
 #define TASKSTATISTIC_H
 
+#include <QObject>
 #include <QMap>
 #include <QList>
 #include "taskdbManager.h"
 
+// 统计引擎：用一次聚合查询（COUNT/SUM/GROUP BY）初始化计数，之后根据TaskDBManager::tasksChanged
+// 增量加减，读取统计只需遍历分类/优先级，不再加载任务。
+// 逾期数在写操作时同样增量维护，到达下一个截止时间后只需重查逾期部分（见applyOverdue）
+class TaskStatEngine : public QObject
+{
+    Q_OBJECT
+public:
+    static TaskStatEngine* getInstance();
+
+    int total();
+    int unfinished();
+    int overdue();
+    QMap<QString, QPair<int, int>> byCategory();   // 分类 → (已完成, 未完成)
+    QMap<int, QPair<int, int>> byPriority();       // 优先级 → (已完成, 未完成)
+
+    // 用外部（如工作线程）查到的聚合结果重置计数，调用方需保证查询后没有新的写入
+    void applyAggregates(const TaskAggregates& aggregates);
+    // 只重置逾期数和下一个截止时间，要求同上
+    void applyOverdue(const TaskOverdueState& state);
+    // 逾期数在此之前保持不变；无效表示没有待到期的未完成任务
+    QDateTime overdueValidUntil() const { return m_overdueValidUntil; }
+
+private:
+    explicit TaskStatEngine(QObject *parent = nullptr);
+
+    void ensureSeeded();
+    void reload();                                  // 重新执行聚合查询，重置全部计数
+    void onTasksChanged(const TaskChangeSet& changes);
+    void count(const Task& task, int delta, const QDateTime& now);  // 把一个任务计入(+1)或移出(-1)各计数
+
+    bool m_seeded = false;
+    int m_total = 0;
+    int m_unfinished = 0;
+    int m_overdue = 0;
+    QDateTime m_overdueValidUntil;                  // 无效表示没有待到期的未完成任务
+    QMap<QString, QPair<int, int>> m_byCategory;
+    QMap<int, QPair<int, int>> m_byPriority;
+
+    static TaskStatEngine* m_instance;
+};
+
+// 趋势统计的时间粒度
+enum class TrendBucket { Day, Week };
+
+// 趋势中的一个时间段（按周时start为周一）
+struct TaskTrendPoint {
+    QDate start;
+    int created = 0;
+    int completed = 0;
+    int overdue = 0;                  // 截止于该时段、已过期仍未完成
+};
+
 class TaskStatistic
 {
 public:
     static QMap<QString, QPair<int, int>> statByCategory();
+    static QMap<int, QPair<int, int>> statByPriority();
     static float getCompletionRate();
     static void statTotal(int& total, int& unfinished);
+    static int statOverdue();
+    // [from, to]内的创建/完成/逾期趋势，来自task_daily_stats，没有任务的时段补0
+    static QList<TaskTrendPoint> statTrend(const QDate& from, const QDate& to, TrendBucket bucket);
+    // 同上，按日统计由调用方提供（不访问数据库，可在工作线程调用）
+    static QList<TaskTrendPoint> statTrend(const QList<TaskDailyStat>& stats, const QDate& from,
+                                           const QDate& to, TrendBucket bucket);
 };
 
 #endif
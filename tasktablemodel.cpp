@@ -0,0 +1,562 @@
+#include "tasktablemodel.h"
+#include <QSet>
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+static const qint64 kInvalidTime = std::numeric_limits<qint64>::min();
+
+static qint64 timeToMs(const QDateTime& time)
+{
+    return time.isValid() ? time.toMSecsSinceEpoch() : kInvalidTime;
+}
+
+// 更新时间在数据库中只存到秒，排序键也截到秒，否则内存中的顺序会与分页查询不一致
+static qint64 updateTimeToMs(const QDateTime& time)
+{
+    return time.isValid() ? time.toSecsSinceEpoch() * 1000 : kInvalidTime;
+}
+
+// 按排列perm重排一列：新的第i行取原来的第perm[i]行（perm可以只含部分行，即筛掉其余行）
+template <typename T>
+static void permuteColumn(QVector<T>& column, const QVector<int>& perm)
+{
+    QVector<T> sorted;
+    sorted.reserve(column.size());
+    for (int from : perm) {
+        sorted.append(column.at(from));
+    }
+    column.swap(sorted);
+}
+
+// 把一列的第from个元素移到第to个位置，其间的元素顺移一位
+template <typename T>
+static void moveElement(QVector<T>& column, int from, int to)
+{
+    if (from < to) {
+        std::rotate(column.begin() + from, column.begin() + from + 1, column.begin() + to + 1);
+    } else if (to < from) {
+        std::rotate(column.begin() + to, column.begin() + from, column.begin() + from + 1);
+    }
+}
+
+TaskTableModel::TaskTableModel(QObject *parent)
+    : QAbstractTableModel(parent)
+{
+    // 与TaskDBManager同在主线程，写操作返回前列表即已更新
+    connect(TaskDBManager::getInstance(), &TaskDBManager::tasksChanged,
+            this, &TaskTableModel::onTasksChanged);
+}
+
+int TaskTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_ids.size();
+}
+
+int TaskTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant TaskTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_ids.size()) return QVariant();
+
+    int row = index.row();
+    if (role == Qt::DisplayRole) {
+        switch (index.column()) {
+        case ColId:          return m_ids.at(row);
+        case ColTitle:       return m_titles.at(row);
+        case ColCategory:    return m_categoryNames.at(m_categories.at(row));
+        case ColPriority:    return m_priorities.at(row);
+        case ColDeadline: {
+            qint64 ms = m_deadlines.at(row);
+            return ms == kInvalidTime ? QString() : QDateTime::fromMSecsSinceEpoch(ms).toString("yyyy-MM-dd HH:mm:ss");
+        }
+        case ColCompleted:   return m_completed.at(row) ? "已完成" : "未完成";
+        case ColDescription: return m_descriptions.at(row);
+        default:             break;
+        }
+    } else if (role == Qt::TextAlignmentRole) {
+        if (index.column() == ColId || index.column() == ColPriority) {
+            return int(Qt::AlignCenter);
+        }
+    }
+    return QVariant();
+}
+
+QVariant TaskTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+
+    switch (section) {
+    case ColId:          return "ID";
+    case ColTitle:       return "任务标题";
+    case ColCategory:    return "分类";
+    case ColPriority:    return "优先级";
+    case ColDeadline:    return "截止时间";
+    case ColCompleted:   return "完成状态";
+    case ColDescription: return "描述";
+    default:             return QVariant();
+    }
+}
+
+void TaskTableModel::sort(int column, Qt::SortOrder order)
+{
+    if (column < kDefaultOrder || column >= ColumnCount) return;
+    m_sortColumn = column;
+    m_sortOrder = (column == kDefaultOrder) ? Qt::DescendingOrder : order;
+
+    // 只加载了前几页时无法在内存中重排：新顺序可分页则重新取第一页，否则加载全部
+    if (!m_atEnd) {
+        reload();
+        return;
+    }
+
+    // 只重排行，不重置模型；选中项等持久索引按任务id跟随到新位置
+    emit layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+    const QModelIndexList persistent = persistentIndexList();
+    QList<int> persistentIds;
+    persistentIds.reserve(persistent.size());
+    for (const QModelIndex& index : persistent) {
+        persistentIds.append(m_ids.value(index.row(), -1));
+    }
+
+    sortRows();
+
+    QModelIndexList moved;
+    moved.reserve(persistent.size());
+    for (int i = 0; i < persistent.size(); ++i) {
+        int row = rowOfId(persistentIds.at(i));
+        moved.append(row < 0 ? QModelIndex() : index(row, persistent.at(i).column()));
+    }
+    changePersistentIndexList(persistent, moved);
+    emit layoutChanged({}, QAbstractItemModel::VerticalSortHint);
+}
+
+bool TaskTableModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && !m_atEnd;
+}
+
+void TaskTableModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid() || m_atEnd) return;
+
+    const QList<Task> page = nextPage();
+    if (page.isEmpty()) return;
+
+    beginInsertRows(QModelIndex(), m_ids.size(), m_ids.size() + page.size() - 1);
+    for (const Task& task : page) {
+        insertRowData(m_ids.size(), task);
+    }
+    endInsertRows();
+}
+
+void TaskTableModel::setCategory(const QString& category)
+{
+    m_category = category;
+    reload();
+}
+
+void TaskTableModel::setSearchText(const QString& text)
+{
+    QString trimmed = text.trimmed();
+    if (trimmed == m_searchText) return;
+    m_searchText = trimmed;
+    reload();
+}
+
+void TaskTableModel::reload()
+{
+    beginResetModel();
+    clearRows();
+    m_atEnd = true;
+
+    if (!m_searchText.isEmpty()) {
+        // 检索模式：结果按相关度排列，分类筛选在结果上进行
+        const QList<Task> results = TaskDBManager::getInstance()->searchTasks(m_searchText, kSearchLimit);
+        for (const Task& task : results) {
+            if (matchesFilter(task)) insertRowData(m_ids.size(), task);
+        }
+        sortRows();
+    } else if (isPagedOrder()) {
+        // 浏览模式按更新时间/优先级：只加载第一页，其余由视图滚动时通过fetchMore按需获取
+        m_atEnd = false;
+        for (const Task& task : nextPage()) {
+            insertRowData(m_ids.size(), task);
+        }
+    } else {
+        // 浏览模式按其他列：排序需要全部任务，取任务缓存快照在内存中排序
+        const QList<Task> tasks = TaskDBManager::getInstance()->getAllTasks();
+        for (const Task& task : tasks) {
+            if (matchesFilter(task)) insertRowData(m_ids.size(), task);
+        }
+        sortRows();
+    }
+
+    endResetModel();
+    qDebug() << "任务列表已加载行数：" << m_ids.size();
+}
+
+int TaskTableModel::taskIdAt(int row) const
+{
+    return (row >= 0 && row < m_ids.size()) ? m_ids.at(row) : -1;
+}
+
+Task TaskTableModel::taskAt(int row) const
+{
+    int id = taskIdAt(row);
+    return id < 0 ? Task() : TaskDBManager::getInstance()->getTaskById(id);
+}
+
+void TaskTableModel::onTasksChanged(const TaskChangeSet& changes)
+{
+    // 检索结果依赖全文索引的相关度，变更后重新检索（结果集有上限）
+    if (!m_searchText.isEmpty()) {
+        reload();
+        return;
+    }
+
+    if (changes.added.size() + changes.updated.size() + changes.removed.size() > kRowUpdateLimit) {
+        rebuildWithChanges(changes);
+        return;
+    }
+
+    for (const Task& task : changes.removed) {
+        int row = rowOfId(task.id);
+        if (row < 0) continue;
+        beginRemoveRows(QModelIndex(), row, row);
+        removeRowData(row);
+        endRemoveRows();
+    }
+
+    // 分页未取完时，排在已加载的最后一行之后的任务不插入，滚动到时由下一页取回
+    for (const Task& task : changes.added) {
+        if (!matchesFilter(task)) continue;
+        int row = insertPosition(keyOf(task));
+        if (!m_atEnd && row == m_ids.size()) continue;
+        beginInsertRows(QModelIndex(), row, row);
+        insertRowData(row, task);
+        endInsertRows();
+    }
+
+    for (const auto& change : changes.updated) {
+        const Task& task = change.second;
+        int row = rowOfId(task.id);
+        bool matches = matchesFilter(task);
+
+        if (row < 0) {
+            // 改了分类等，新进入当前筛选
+            if (!matches) continue;
+            int newRow = insertPosition(keyOf(task));
+            if (!m_atEnd && newRow == m_ids.size()) continue;
+            beginInsertRows(QModelIndex(), newRow, newRow);
+            insertRowData(newRow, task);
+            endInsertRows();
+            continue;
+        }
+
+        int newRow = matches ? insertPosition(keyOf(task), row) : -1;
+        if (!matches || (!m_atEnd && newRow == m_ids.size() - 1)) {
+            // 不再符合筛选，或移到了已加载的行之后
+            beginRemoveRows(QModelIndex(), row, row);
+            removeRowData(row);
+            endRemoveRows();
+        } else {
+            // 排序键变化导致位置改变时移动该行，否则原地更新
+            int dest = (newRow <= row) ? newRow : newRow + 1;  // beginMoveRows以移动前的行号表示目标
+            if (dest != row && dest != row + 1) {
+                beginMoveRows(QModelIndex(), row, row, QModelIndex(), dest);
+                moveRowData(row, newRow);
+                endMoveRows();
+                row = newRow;
+            }
+            writeRowData(row, task);
+            emit dataChanged(index(row, 0), index(row, ColumnCount - 1), {Qt::DisplayRole});
+        }
+    }
+}
+
+void TaskTableModel::rebuildWithChanges(const TaskChangeSet& changes)
+{
+    // 去掉删除和修改的行，再追加新增和修改后仍符合筛选的任务，最后整体重排；
+    // 分页未取完时，排到剩下的最后一行之后的任务丢弃，由下一页取回
+    QSet<int> dropped;
+    dropped.reserve(changes.removed.size() + changes.updated.size());
+    for (const Task& task : changes.removed) dropped.insert(task.id);
+    for (const auto& change : changes.updated) dropped.insert(change.second.id);
+
+    beginResetModel();
+    m_rowOfId.clear();  // 行号在末尾重排时统一重建
+    QVector<int> kept;
+    kept.reserve(m_ids.size());
+    for (int row = 0; row < m_ids.size(); ++row) {
+        if (!dropped.contains(m_ids.at(row))) kept.append(row);
+    }
+    if (kept.size() != m_ids.size()) {
+        permuteColumn(m_ids, kept);
+        permuteColumn(m_titles, kept);
+        permuteColumn(m_categories, kept);
+        permuteColumn(m_priorities, kept);
+        permuteColumn(m_deadlines, kept);
+        permuteColumn(m_updateTimes, kept);
+        permuteColumn(m_completed, kept);
+        permuteColumn(m_descriptions, kept);
+    }
+    bool hasBoundary = !m_atEnd && !m_ids.isEmpty();
+    SortKey boundary = hasBoundary ? keyAt(m_ids.size() - 1) : SortKey();
+
+    for (const Task& task : changes.added) {
+        if (matchesFilter(task)) insertRowData(m_ids.size(), task);
+    }
+    for (const auto& change : changes.updated) {
+        if (matchesFilter(change.second)) insertRowData(m_ids.size(), change.second);
+    }
+    sortRows();
+    if (!m_atEnd) {
+        truncateRows(hasBoundary ? insertPosition(boundary) : 0);
+    }
+    endResetModel();
+}
+
+bool TaskTableModel::matchesFilter(const Task& task) const
+{
+    return m_category.isEmpty() || task.category == m_category;
+}
+
+int TaskTableModel::internCategory(const QString& category)
+{
+    auto it = m_categoryIndex.constFind(category);
+    if (it != m_categoryIndex.constEnd()) return it.value();
+    int index = m_categoryNames.size();
+    m_categoryNames.append(category);
+    m_categoryIndex.insert(category, index);
+    return index;
+}
+
+int TaskTableModel::rowOfId(int id) const
+{
+    return m_rowOfId.value(id, -1);
+}
+
+void TaskTableModel::reindexRows(int from, int to)
+{
+    for (int row = from; row < to; ++row) {
+        m_rowOfId.insert(m_ids.at(row), row);
+    }
+}
+
+bool TaskTableModel::isPagedOrder() const
+{
+    return m_searchText.isEmpty() && (m_sortColumn == kDefaultOrder || m_sortColumn == ColPriority);
+}
+
+QList<Task> TaskTableModel::nextPage()
+{
+    // 以已加载的最后一行作为游标，只需id和排序列
+    Task after;
+    if (!m_ids.isEmpty()) {
+        int last = m_ids.size() - 1;
+        after.id = m_ids.at(last);
+        after.priority = m_priorities.at(last);
+        if (m_updateTimes.at(last) != kInvalidTime) {
+            after.updateTime = QDateTime::fromMSecsSinceEpoch(m_updateTimes.at(last));
+        }
+    }
+
+    TaskSortKey sortKey = (m_sortColumn == ColPriority) ? TaskSortKey::Priority : TaskSortKey::UpdateTime;
+    QList<Task> page = TaskDBManager::getInstance()->getTasksPage(
+        sortKey, m_sortOrder == Qt::AscendingOrder, after, kPageSize, m_category);
+    if (page.size() < kPageSize) {
+        m_atEnd = true;
+    }
+    return page;
+}
+
+bool TaskTableModel::isTextColumn() const
+{
+    return m_sortColumn == ColTitle || m_sortColumn == ColCategory || m_sortColumn == ColDescription;
+}
+
+TaskTableModel::SortKey TaskTableModel::keyOf(const Task& task) const
+{
+    SortKey key;
+    switch (m_sortColumn) {
+    case ColId:          key.num = task.id; break;
+    case ColTitle:       key.text = task.title; break;
+    case ColCategory:    key.text = task.category; break;
+    case ColPriority:    key.num = task.priority; break;
+    case ColDeadline:    key.num = timeToMs(task.deadline); break;
+    case ColCompleted:   key.num = task.isCompleted ? 1 : 0; break;
+    case ColDescription: key.text = task.description; break;
+    default:             key.num = updateTimeToMs(task.updateTime); break;
+    }
+    key.id = task.id;
+    return key;
+}
+
+TaskTableModel::SortKey TaskTableModel::keyAt(int row) const
+{
+    SortKey key;
+    switch (m_sortColumn) {
+    case ColId:          key.num = m_ids.at(row); break;
+    case ColTitle:       key.text = m_titles.at(row); break;
+    case ColCategory:    key.text = m_categoryNames.at(m_categories.at(row)); break;
+    case ColPriority:    key.num = m_priorities.at(row); break;
+    case ColDeadline:    key.num = m_deadlines.at(row); break;
+    case ColCompleted:   key.num = m_completed.at(row) ? 1 : 0; break;
+    case ColDescription: key.text = m_descriptions.at(row); break;
+    default:             key.num = m_updateTimes.at(row); break;
+    }
+    key.id = m_ids.at(row);
+    return key;
+}
+
+bool TaskTableModel::keyLess(const SortKey& a, const SortKey& b) const
+{
+    int cmp;
+    if (isTextColumn()) {
+        cmp = QString::compare(a.text, b.text);
+    } else {
+        cmp = (a.num < b.num) ? -1 : (a.num > b.num ? 1 : 0);
+    }
+    if (cmp == 0) {
+        cmp = (a.id < b.id) ? -1 : (a.id > b.id ? 1 : 0);
+    }
+    return m_sortOrder == Qt::AscendingOrder ? cmp < 0 : cmp > 0;
+}
+
+int TaskTableModel::insertPosition(const SortKey& key, int skipRow) const
+{
+    // 在去掉skipRow后的行中二分查找第一个排在key之后的位置
+    int low = 0;
+    int high = m_ids.size() - (skipRow >= 0 ? 1 : 0);
+    while (low < high) {
+        int mid = (low + high) / 2;
+        int row = (skipRow >= 0 && mid >= skipRow) ? mid + 1 : mid;
+        if (keyLess(key, keyAt(row))) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return low;
+}
+
+void TaskTableModel::sortRows()
+{
+    // 检索模式的默认顺序即相关度，保持不动
+    if (m_sortColumn == kDefaultOrder && !m_searchText.isEmpty()) {
+        reindexRows(0, m_ids.size());
+        return;
+    }
+
+    // 先取出排序键再排下标，避免比较时反复构造
+    int count = m_ids.size();
+    QVector<SortKey> keys;
+    keys.reserve(count);
+    for (int row = 0; row < count; ++row) {
+        keys.append(keyAt(row));
+    }
+    QVector<int> perm(count);
+    std::iota(perm.begin(), perm.end(), 0);
+    std::stable_sort(perm.begin(), perm.end(), [this, &keys](int a, int b) {
+        return keyLess(keys.at(a), keys.at(b));
+    });
+
+    permuteColumn(m_ids, perm);
+    permuteColumn(m_titles, perm);
+    permuteColumn(m_categories, perm);
+    permuteColumn(m_priorities, perm);
+    permuteColumn(m_deadlines, perm);
+    permuteColumn(m_updateTimes, perm);
+    permuteColumn(m_completed, perm);
+    permuteColumn(m_descriptions, perm);
+    reindexRows(0, count);
+}
+
+void TaskTableModel::insertRowData(int row, const Task& task)
+{
+    m_ids.insert(row, task.id);
+    m_titles.insert(row, task.title);
+    m_categories.insert(row, internCategory(task.category));
+    m_priorities.insert(row, task.priority);
+    m_deadlines.insert(row, timeToMs(task.deadline));
+    m_updateTimes.insert(row, updateTimeToMs(task.updateTime));
+    m_completed.insert(row, task.isCompleted);
+    m_descriptions.insert(row, task.description);
+    // 其后各行下移一位；追加到末尾时只登记这一行
+    reindexRows(row, m_ids.size());
+}
+
+void TaskTableModel::writeRowData(int row, const Task& task)
+{
+    m_titles[row] = task.title;
+    m_categories[row] = internCategory(task.category);
+    m_priorities[row] = task.priority;
+    m_deadlines[row] = timeToMs(task.deadline);
+    m_updateTimes[row] = updateTimeToMs(task.updateTime);
+    m_completed[row] = task.isCompleted;
+    m_descriptions[row] = task.description;
+}
+
+void TaskTableModel::moveRowData(int from, int to)
+{
+    moveElement(m_ids, from, to);
+    moveElement(m_titles, from, to);
+    moveElement(m_categories, from, to);
+    moveElement(m_priorities, from, to);
+    moveElement(m_deadlines, from, to);
+    moveElement(m_updateTimes, from, to);
+    moveElement(m_completed, from, to);
+    moveElement(m_descriptions, from, to);
+    // 只有两个位置之间的行号变化
+    reindexRows(qMin(from, to), qMax(from, to) + 1);
+}
+
+void TaskTableModel::removeRowData(int row)
+{
+    m_rowOfId.remove(m_ids.at(row));
+    m_ids.remove(row);
+    m_titles.remove(row);
+    m_categories.remove(row);
+    m_priorities.remove(row);
+    m_deadlines.remove(row);
+    m_updateTimes.remove(row);
+    m_completed.remove(row);
+    m_descriptions.remove(row);
+    reindexRows(row, m_ids.size());
+}
+
+void TaskTableModel::truncateRows(int count)
+{
+    for (int row = count; row < m_ids.size(); ++row) {
+        m_rowOfId.remove(m_ids.at(row));
+    }
+    m_ids.resize(count);
+    m_titles.resize(count);
+    m_categories.resize(count);
+    m_priorities.resize(count);
+    m_deadlines.resize(count);
+    m_updateTimes.resize(count);
+    m_completed.resize(count);
+    m_descriptions.resize(count);
+}
+
+void TaskTableModel::clearRows()
+{
+    m_ids.clear();
+    m_titles.clear();
+    m_categories.clear();
+    m_priorities.clear();
+    m_deadlines.clear();
+    m_updateTimes.clear();
+    m_completed.clear();
+    m_descriptions.clear();
+    m_rowOfId.clear();
+    m_categoryNames.clear();
+    m_categoryIndex.clear();
+}
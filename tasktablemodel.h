@@ -0,0 +1,112 @@
+#ifndef TASKTABLEMODEL_H
+#define TASKTABLEMODEL_H
+
+#include <QAbstractTableModel>
+#include <QList>
+#include <QVector>
+#include <QStringList>
+#include <QHash>
+#include "taskdbmanager.h"
+
+// 任务列表模型：列式快照，data()直接按下标取值。
+// 按更新时间或优先级排序时用键集分页从数据库按需加载，视图滚动到底部时再取下一页；
+// 按其他列排序需要全部任务，改为取TaskDBManager的任务缓存在内存中排序。
+// 任务增删改通过tasksChanged逐行插入/更新/移除，不整体重置（排在已加载行之后的留给下一页）；
+// 一次变更较多（如导入）时改为一趟重建后整体重置。
+// 设置了搜索词时改为显示按相关度排序的检索结果
+class TaskTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    enum Column {
+        ColId = 0,
+        ColTitle,
+        ColCategory,
+        ColPriority,
+        ColDeadline,
+        ColCompleted,
+        ColDescription,
+        ColumnCount
+    };
+
+    // 默认顺序：浏览时按更新时间降序，检索时按相关度
+    static const int kDefaultOrder = -1;
+
+    explicit TaskTableModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+    // 筛选条件变化后重建快照（可分页的排序只取第一页）
+    void setCategory(const QString& category);   // 空字符串表示全部分类
+    void setSearchText(const QString& text);     // 非空时显示全文检索结果
+    void reload();
+
+    int taskIdAt(int row) const;
+    Task taskAt(int row) const;
+
+private:
+    // 排序键：数值列用num，文本列用text；键相等时按id同向排序，与分页查询的顺序一致
+    struct SortKey {
+        qint64 num = 0;
+        QString text;
+        int id = -1;
+    };
+
+    void onTasksChanged(const TaskChangeSet& changes);
+    void rebuildWithChanges(const TaskChangeSet& changes);
+    bool matchesFilter(const Task& task) const;
+    int internCategory(const QString& category);
+    int rowOfId(int id) const;
+    void reindexRows(int from, int to);             // 登记[from, to)各行的行号
+
+    bool isPagedOrder() const;                      // 当前顺序可由getTasksPage分页
+    QList<Task> nextPage();                         // 取已加载的最后一行之后的一页
+
+    bool isTextColumn() const;
+    SortKey keyOf(const Task& task) const;
+    SortKey keyAt(int row) const;
+    bool keyLess(const SortKey& a, const SortKey& b) const;  // 已按当前升降序处理
+    int insertPosition(const SortKey& key, int skipRow = -1) const;  // 相等键之后的位置
+    void sortRows();                                // 按当前排序键稳定排序（不发信号）
+
+    void insertRowData(int row, const Task& task);
+    void writeRowData(int row, const Task& task);
+    void moveRowData(int from, int to);
+    void removeRowData(int row);
+    void truncateRows(int count);
+    void clearRows();
+
+    static const int kPageSize = 200;    // 分页加载时每页行数
+    static const int kSearchLimit = 500; // 检索结果最多显示的行数
+    // 逐行更新每行都要查找和搬移O(n)，变更行数超过此值时一趟重建
+    static const int kRowUpdateLimit = 64;
+
+    // 列式快照：每列一个连续数组，第row行即各数组的第row个元素
+    QVector<int> m_ids;
+    QVector<QString> m_titles;
+    QVector<int> m_categories;          // m_categoryNames的下标
+    QVector<int> m_priorities;
+    QVector<qint64> m_deadlines;        // msecsSinceEpoch
+    QVector<qint64> m_updateTimes;      // 默认排序键，精确到秒
+    QVector<bool> m_completed;
+    QVector<QString> m_descriptions;
+    QHash<int, int> m_rowOfId;          // id → 行号，随行的增删移动维护
+
+    QStringList m_categoryNames;        // 分类名驻留表，每个分类只存一份
+    QHash<QString, int> m_categoryIndex;
+
+    QString m_category;
+    QString m_searchText;
+    int m_sortColumn = kDefaultOrder;
+    Qt::SortOrder m_sortOrder = Qt::DescendingOrder;
+    bool m_atEnd = true;                // 已加载全部符合条件的行（未分页或已取完）
+};
+
+#endif